@@ -2,310 +2,923 @@
 
 using namespace uvdar;
 
-AMI::AMI(const loadedParamsForAMI& i_params){
+namespace {
+    int64_t steadyClockNs(){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    constexpr uint32_t snapshot_version = 2;
+
+    // parameters in a snapshot, fixed-size record independent of loadedParamsForAMI
+    struct SnapshotParams{
+        int32_t max_px_shift_x;
+        int32_t max_px_shift_y;
+        int32_t max_zeros_consecutive;
+        int32_t stored_seq_len_factor;
+        int32_t max_buffer_length;
+        int32_t poly_order;
+        double decay_factor;
+        double conf_probab_percent;
+        int32_t allowed_BER_per_seq;
+        int32_t predictor_mode;
+        double kalman_process_noise;
+        double kalman_measurement_noise;
+    };
+
+    // tracker state besides the tracks
+    struct SnapshotState{
+        uint64_t next_track_id;
+        int64_t frame_stamp_ns;
+        int64_t now_ns;
+        uint64_t processed_frames;
+        uint32_t track_count;
+    };
+}
+
+AMI::AMI(const loadedParamsForAMI& i_params, std::shared_ptr<WorkerPool> worker_pool){
 
     *loaded_params_ = i_params;
-    extended_search_ = std::make_unique<ExtendedSearch>(loaded_params_->decay_factor);
+    frame_index_ = std::make_unique<SpatialGrid>(loaded_params_->max_px_shift);
+    events_.reset((size_t)std::max(loaded_params_->event_queue_length, 0));
+    worker_pool_ = std::move(worker_pool);
+    if(!worker_pool_ && loaded_params_->worker_threads > 0){
+        worker_pool_ = std::make_shared<WorkerPool>(loaded_params_->worker_threads);
+    }
+
+    if(loaded_params_->poly_order > max_poly_order){
+        AMI_LOG_WARN("[AMI]: The polynomial order %d is not supported, the order is limited to %d.", loaded_params_->poly_order, max_poly_order);
+        loaded_params_->poly_order = max_poly_order;
+    }
+
+    // started last, the tracker thread reads the parameters
+    if(loaded_params_->async_queue_length > 0){
+        frame_queue_ = std::make_unique<FrameQueue>(loaded_params_->async_queue_length);
+        tracker_thread_ = std::thread(&AMI::trackerLoop, this);
+    }
 }
 
 void AMI::setDebugFlags(bool i_debug){
-    debug_ = i_debug;
+    // the trace ring is only allocated for a tracker that traces, before the first event
+    if(i_debug)
+        AMI_ENABLE_TRACE(instrumentation_);
+    debug_.store(i_debug, std::memory_order_release);
+}
+
+void AMI::setClock(std::unique_ptr<Clock> clock){
+    std::scoped_lock lock(mutex_gen_sequences_);
+    if(clock)
+        clock_ = std::move(clock);
 }
 
 void AMI::updateFramerate(double input) {
   if (input > 1.0)
     framerate_ = input;
+  if (framerate_ > 0.0 && loaded_params_->frame_budget_fraction > 0.0)
+    frame_budget_ns_ = (int64_t)(loaded_params_->frame_budget_fraction * 1e9 / framerate_);
 }
 
 bool AMI::setSequences(std::vector<std::vector<bool>> i_sequences){
   
-    original_sequences_ = i_sequences;
-    matcher_ = std::make_unique<SignalMatcher>(original_sequences_, loaded_params_->allowed_BER_per_seq, true);
-    if(original_sequences_.size() == 0)
+    return setSequences(std::make_shared<const SequenceTables>(i_sequences, loaded_params_->allowed_BER_per_seq, loaded_params_->stored_seq_len_factor, loaded_params_->decay_factor, loaded_params_->conf_probab_percent));
+}
+
+bool AMI::setSequences(std::shared_ptr<const SequenceTables> i_tables){
+
+    if(!i_tables || i_tables->sequences().size() == 0)
         return false;
 
-    if( ( loaded_params_->stored_seq_len_factor * (int)original_sequences_[0].size() )  < loaded_params_->max_zeros_consecutive){
-        ROS_ERROR("[AMI]: The wanted number of consecutive zeros is higher than the possible sequence length in the buffer! Sequence cannot be set. Returning..");
+    track_capacity_ = i_tables->trackCapacity();
+    {
+        std::scoped_lock lock(mutex_gen_sequences_);
+        tables_ = std::move(i_tables);
+        predictor_ = createPredictor();
+        for(const auto& handle : gen_sequences_)
+            recordEvent(TrackEventType::lost, handle, track_pool_[handle]);
+        events_.commit();
+        gen_sequences_.clear();
+        gen_sequences_.reserve(std::max(loaded_params_->max_buffer_length, 0));
+        track_pool_.reset(loaded_params_->max_buffer_length, track_capacity_);
+    }
+    if(track_capacity_ < loaded_params_->max_zeros_consecutive){
+        AMI_LOG_ERROR("[AMI]: The wanted number of consecutive zeros is higher than the possible sequence length in the buffer! Sequence cannot be set. Returning..");
         return false;
     }
     return true;
 }
 
-void AMI::processBuffer(const uvdar_core::ImagePointsWithFloatStampedConstPtr pts_msg) {
+std::unique_ptr<Predictor> AMI::createPredictor() const{
 
-    std::vector<PointState> current_frame;
-    for ( auto point_time_stamp : pts_msg->points) {
-        PointState p;
-        p.point = cv::Point(point_time_stamp.x, point_time_stamp.y);
-        p.led_state = true;
-        p.insert_time = pts_msg->stamp;
-        current_frame.push_back(p);
+    switch(loaded_params_->predictor_mode){
+        case PredictorMode::constant_velocity:
+        case PredictorMode::constant_acceleration:
+            return std::make_unique<KalmanPredictor>(loaded_params_->predictor_mode, KalmanNoise{loaded_params_->kalman_process_noise, loaded_params_->kalman_measurement_noise}, loaded_params_->conf_probab_percent);
+        default:
+            return std::make_unique<RegressionPredictor>(tables_, loaded_params_->predictor_mode == PredictorMode::recursive_least_squares, loaded_params_->poly_order, loaded_params_->decay_factor, loaded_params_->conf_probab_percent);
     }
-    
-    findClosestPixelAndInsert(current_frame);
-    cleanPotentialBuffer();
 }
 
-void AMI::findClosestPixelAndInsert(std::vector<PointState> & current_frame) {   
-    
-    std::vector<seqPointer> p_gen_seq;
+void AMI::submitFrame(const PointsView& points, const int64_t& stamp_ns) {
+
+    recordFrame(points, stamp_ns);
+    if(!frame_queue_){
+        processFrame(points, stamp_ns);
+        return;
+    }
+    frame_queue_->push(points, stamp_ns, loaded_params_->backpressure_policy);
+}
+
+bool AMI::recordFrames(const std::string& path) {
+
+    std::scoped_lock lock(mutex_recorder_);
+    recording_.store(false, std::memory_order_release);
+    if(!recorder_.close()){
+        AMI_LOG_ERROR("[AMI]: The end of the frame log could not be written.");
+    }
+    if(path.empty())
+        return true;
+    if(!recorder_.open(path)){
+        AMI_LOG_ERROR("[AMI]: The frame log %s cannot be created.", path.c_str());
+        return false;
+    }
+    recording_.store(true, std::memory_order_release);
+    return true;
+}
+
+void AMI::recordFrame(const PointsView& points, const int64_t& stamp_ns) {
+
+    if(!recording_.load(std::memory_order_acquire))
+        return;
+    std::scoped_lock lock(mutex_recorder_);
+    if(recorder_.isOpen() && !recorder_.append(points, stamp_ns)){
+        AMI_LOG_ERROR("[AMI]: The frame log cannot be written, the recording is stopped.");
+        recorder_.close();
+        recording_.store(false, std::memory_order_release);
+    }
+}
+
+void AMI::trackerLoop() {
+
+    while(frame_queue_->waitPop(tracker_frame_)){
+        const int64_t start_ns = steadyClockNs();
+        queue_wait_.record((uint64_t)std::max<int64_t>(start_ns - tracker_frame_.enqueue_ns, 0));
+
+        // coalescing: in a backlog only the newest frame is published
+        const bool publish = loaded_params_->backpressure_policy != BackpressurePolicy::coalesce || frame_queue_->depth() == 0;
+        processFrame(PointsView::fromInterleaved(tracker_frame_.xy.data(), tracker_frame_.xy.size() / 2), tracker_frame_.stamp_ns, publish);
+        if(!publish)
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+
+        frame_latency_.record((uint64_t)std::max<int64_t>(steadyClockNs() - tracker_frame_.enqueue_ns, 0));
+        async_processed_.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void AMI::flush() {
+
+    if(!frame_queue_)
+        return;
+    while(async_processed_.load(std::memory_order_acquire) + frame_queue_->dropped() < frame_queue_->enqueued()){
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+IngestionStatistics AMI::getIngestionStatistics() const {
+
+    IngestionStatistics statistics;
+    statistics.policy = loaded_params_->backpressure_policy;
+    if(!frame_queue_)
+        return statistics;
+    statistics.asynchronous = true;
+    statistics.capacity = frame_queue_->capacity();
+    statistics.depth = frame_queue_->depth();
+    statistics.max_depth = frame_queue_->maxDepth();
+    statistics.enqueued = frame_queue_->enqueued();
+    statistics.processed = async_processed_.load(std::memory_order_relaxed);
+    statistics.dropped = frame_queue_->dropped();
+    statistics.coalesced = coalesced_.load(std::memory_order_relaxed);
+    statistics.queue_wait = queue_wait_.statistics();
+    statistics.latency = frame_latency_.statistics();
+    return statistics;
+}
+
+void AMI::processFrame(const PointsView& points, const int64_t& stamp_ns, const bool& publish) {
+
+    std::scoped_lock frame_lock(mutex_frame_);
+    AMI_STAGE_TIMER(instrumentation_, Stage::frame);
+    AMI_COUNT(instrumentation_, frames, 1);
+    AMI_COUNT(instrumentation_, points, points.size());
+    frame_stamp_ns_ = stamp_ns;
+    processed_frames_++;
+    degradation_ = FrameDegradation();
+    current_budget_ns_ = frame_budget_ns_;
+    if(current_budget_ns_ > 0)
+        frame_start_ns_ = steadyClockNs();
     {
-        std::scoped_lock lock(mutex_gen_sequences_);
-        p_gen_seq = gen_sequences_;
-    }    
+    std::scoped_lock lock(mutex_gen_sequences_);
+    now_ns_ = clock_->nowNs(stamp_ns);
+    }
+    findClosestPixelAndInsert(points);
+
+    // over budget: the pruning can wait, a sequence that should be removed just keeps collecting "off"-points
+    if(remainingBudgetNs() < 0 && deferred_prunings_ < max_deferred_prunings_){
+        deferred_prunings_++;
+        degradation_.pruning_deferred = true;
+        AMI_COUNT(instrumentation_, deferred_prunings, 1);
+    }else{
+        deferred_prunings_ = 0;
+        cleanPotentialBuffer();
+    }
+    if(degradation_.level != DegradationLevel::none)
+        AMI_COUNT(instrumentation_, degraded_frames, 1);
+    if(publish)
+        publishResults();
+    events_.commit();
+}
+
+int64_t AMI::remainingBudgetNs() const {
+
+    if(current_budget_ns_ <= 0)
+        return std::numeric_limits<int64_t>::max();
+    return current_budget_ns_ - (steadyClockNs() - frame_start_ns_);
+}
+
+int AMI::searchPriority(const Track& track) const {
+
+    int id;
+    const bool identified = track.cachedSignalId(id) && id >= 0;
+    return (identified ? track.capacity() : 0) + track.size();
+}
+
+void AMI::findClosestPixelAndInsert(const PointsView& points) {   
     
     {
     std::scoped_lock lock(mutex_gen_sequences_);
-    for(auto seq = p_gen_seq.begin(); seq != p_gen_seq.end();){
-    
-        PointState last_inserted = (*seq)->end()[-1];
-        cv::Point2d bb_left_top = last_inserted.point - cv::Point2d(loaded_params_->max_px_shift);
-        cv::Point2d bb_right_bottom = last_inserted.point + cv::Point2d(loaded_params_->max_px_shift);
+    AMI_STAGE_TIMER(instrumentation_, Stage::local_search);
+    sequences_no_insert_.clear();
+    frame_index_->build(points);
+    const int count = (int)gen_sequences_.size();
+    local_assigned_.assign(count, -1);
+    const bool tiled = worker_pool_ && count > 0 && loaded_params_->local_search_tile_size > 0 && count >= loaded_params_->parallel_search_threshold;
+    if(tiled){
+        tiledLocalSearch();
+    }else{
+        assignment_.reset(frame_index_->size());
+        for(const auto& handle : gen_sequences_){
+            const Track& seq = track_pool_[handle];
         
-        std::vector<PointState>::iterator it; 
-        double closest_distance = std::numeric_limits<double>::max();
-        std::vector<PointState>::iterator it_2 = current_frame.end();
-        for(it = current_frame.begin(); it != current_frame.end(); ++it){
+            const cv::Point2d last_inserted(seq.x(seq.size() - 1), seq.y(seq.size() - 1));
+            cv::Point2d bb_left_top = last_inserted - cv::Point2d(loaded_params_->max_px_shift);
+            cv::Point2d bb_right_bottom = last_inserted + cv::Point2d(loaded_params_->max_px_shift);
             
-            double curr_dist = extended_search_->euclideanDistance((*it).point, last_inserted.point);
-            if(curr_dist <= closest_distance){
-                closest_distance = curr_dist; 
-                it_2 = it;
-            }
+            assignment_.addRow(seq.trackId());
+            addAssignmentCandidates(last_inserted, bb_left_top, bb_right_bottom);
         }
-        if(it_2 != current_frame.end()){
-            if( extended_search_->isInsideBB( (*it_2).point, bb_left_top, bb_right_bottom ) ){
-                insertPointToSequence(**seq, *it_2);    
-                seq = p_gen_seq.erase(seq);
-                it_2 = current_frame.erase(it_2);
-            }else{
-                ++seq;
-            }
+        solveAssignment();
+        for(int i = 0; i < count; ++i){
+            local_assigned_[i] = assignment_.assignedColumn(i);
+            if(local_assigned_[i] != -1)
+                frame_index_->take(local_assigned_[i]);
+        }
+    }
+
+    // the insertions only touch the own sequence
+    auto insert = [&](int i){
+        if(local_assigned_[i] == -1)
+            return;
+        Track& seq = track_pool_[gen_sequences_[i]];
+        insertPointToSequence(seq, frameSample(local_assigned_[i]));
+        seq.resetStatistics();
+    };
+    if(tiled){
+        worker_pool_->parallelFor(count, insert);
+    }else{
+        for(int i = 0; i < count; ++i)
+            insert(i);
+    }
+    for(int i = 0; i < count; ++i){
+        const TrackHandle handle = gen_sequences_[i];
+        if(local_assigned_[i] != -1){
+            recordEvent(TrackEventType::position_updated, handle, track_pool_[handle]);
         }else{
-            ++seq;
+            sequences_no_insert_.push_back(handle);
         }
     }
+    AMI_COUNT(instrumentation_, local_search_hits, gen_sequences_.size() - sequences_no_insert_.size());
     }    
-    extendedSearch(current_frame, p_gen_seq);
+    extendedSearch(sequences_no_insert_);
 }
 
-void AMI::extendedSearch(std::vector<PointState>& no_nn_current_frame, std::vector<seqPointer>& sequences_no_insert){
-    std::scoped_lock lock(mutex_gen_sequences_);
+void AMI::tiledLocalSearch() {
 
-    if((int)no_nn_current_frame.size() != 0){
-        double insert_time = no_nn_current_frame[0].insert_time.toSec() + prediction_margin_;
-        for(auto it_seq = sequences_no_insert.begin();  it_seq != sequences_no_insert.end();){
-            if((*it_seq)->size() == 0)continue;
-
-            std::vector<double> x,y,time;
-            for(const auto point : **it_seq){
-                if(point.led_state){
-                    x.push_back(point.point.x);
-                    y.push_back(point.point.y);
-                    time.push_back(point.insert_time.toSec());
-                }
-            }
+    const int count = (int)gen_sequences_.size();
+    const cv::Point2d shift(loaded_params_->max_px_shift);
 
-            PointState& last_point = (*it_seq)->end()[-1]; 
-            PredictionStatistics x_predictions = selectStatisticsValues(x, time, insert_time);
-            PredictionStatistics y_predictions = selectStatisticsValues(y, time, insert_time);
-            if( !x_predictions.poly_reg_computed || !y_predictions.poly_reg_computed){
-                ++it_seq;
-                continue;
-            }
-            last_point.x_statistics = x_predictions;
-            last_point.y_statistics = y_predictions;
-            double x_predicted = last_point.x_statistics.predicted_coordinate;
-            double y_predicted = last_point.y_statistics.predicted_coordinate;
+    // tiles over the last points of the sequences, at least 4 search windows wide so that most windows lie inside one tile
+    double min_x = std::numeric_limits<double>::max(), min_y = min_x;
+    double max_x = std::numeric_limits<double>::lowest(), max_y = max_x;
+    for(const auto& handle : gen_sequences_){
+        const Track& seq = track_pool_[handle];
+        min_x = std::min<double>(min_x, seq.x(seq.size() - 1));
+        min_y = std::min<double>(min_y, seq.y(seq.size() - 1));
+        max_x = std::max<double>(max_x, seq.x(seq.size() - 1));
+        max_y = std::max<double>(max_y, seq.y(seq.size() - 1));
+    }
+    // the grid covers the whole search windows - a window at the border of the scene lies inside a tile, a single tile gives the serial assignment
+    min_x -= shift.x;
+    min_y -= shift.y;
+    max_x += shift.x;
+    max_y += shift.y;
+    double tile_size = std::max<double>(loaded_params_->local_search_tile_size, 4 * std::max(shift.x, shift.y));
+    int tiles_x = (int)((max_x - min_x) / tile_size) + 1;
+    int tiles_y = (int)((max_y - min_y) / tile_size) + 1;
+    while((int64_t)tiles_x * tiles_y > max_local_search_tiles_){
+        tile_size *= 2;
+        tiles_x = (int)((max_x - min_x) / tile_size) + 1;
+        tiles_y = (int)((max_y - min_y) / tile_size) + 1;
+    }
+    const int tile_count = tiles_x * tiles_y;
+    auto tileOf = [&](const double& x, const double& y){
+        const double col = std::floor((x - min_x) / tile_size), row = std::floor((y - min_y) / tile_size);
+        if(!(col >= 0 && col < tiles_x && row >= 0 && row < tiles_y))
+            return -1;
+        return (int)row * tiles_x + (int)col;
+    };
+
+    // a sequence belongs to a tile if its whole search window lies inside the tile, the others lie in the halo of max_px_shift at a border
+    track_tile_.resize(count);
+    tile_track_start_.assign(tile_count + 1, 0);
+    for(int i = 0; i < count; ++i){
+        const Track& seq = track_pool_[gen_sequences_[i]];
+        const cv::Point2d last_inserted(seq.x(seq.size() - 1), seq.y(seq.size() - 1));
+        const int first = tileOf(last_inserted.x - shift.x, last_inserted.y - shift.y);
+        const int last = tileOf(last_inserted.x + shift.x, last_inserted.y + shift.y);
+        track_tile_[i] = (first == last) ? first : -1;
+        if(track_tile_[i] != -1)
+            tile_track_start_[track_tile_[i] + 1]++;
+    }
+    for(int t = 0; t < tile_count; ++t)
+        tile_track_start_[t + 1] += tile_track_start_[t];
+    tile_tracks_.resize(tile_track_start_[tile_count]);
+    tile_fill_.assign(tile_track_start_.begin(), tile_track_start_.end() - 1);
+    for(int i = 0; i < count; ++i){
+        if(track_tile_[i] != -1)
+            tile_tracks_[tile_fill_[track_tile_[i]]++] = i;
+    }
 
+    // the points of a tile are the columns of its assignment
+    point_column_.resize(frame_index_->size());
+    tile_fill_.assign(tile_count, 0);
+    for(int p = 0; p < frame_index_->size(); ++p){
+        const int tile = tileOf(frame_index_->point(p).x, frame_index_->point(p).y);
+        point_column_[p] = (tile == -1) ? -1 : tile_fill_[tile]++;
+    }
 
-            last_point.x_statistics.confidence_interval = ( last_point.x_statistics.confidence_interval > (loaded_params_->max_px_shift.x * 2) ) ? (loaded_params_->max_px_shift.x * 2) : last_point.x_statistics.confidence_interval;
-            last_point.y_statistics.confidence_interval = ( last_point.y_statistics.confidence_interval > (loaded_params_->max_px_shift.y * 2) ) ? (loaded_params_->max_px_shift.y * 2) : last_point.y_statistics.confidence_interval;
+    // the sequences inside the tiles are assigned concurrently, tile by tile
+    if((int)tiles_.size() < tile_count)
+        tiles_.resize(tile_count);
+    auto solveTile = [&](int t){
+        const int begin = tile_track_start_[t], end = tile_track_start_[t + 1];
+        if(begin == end)
+            return;
+        LocalSearchTile& tile = tiles_[t];
+        tile.assignment.reset(tile_fill_[t]);
+        tile.points.resize(tile_fill_[t]);
+        for(int k = begin; k < end; ++k){
+            const Track& seq = track_pool_[gen_sequences_[tile_tracks_[k]]];
+            const cv::Point2d last_inserted(seq.x(seq.size() - 1), seq.y(seq.size() - 1));
+            tile.assignment.addRow(seq.trackId());
+            tile.candidates.clear();
+            frame_index_->candidatesInBox(last_inserted, last_inserted - shift, last_inserted + shift, tile.candidates);
+            for(const auto& candidate : tile.candidates){
+                tile.points[point_column_[candidate.index]] = candidate.index;
+                tile.assignment.addCandidate(point_column_[candidate.index], candidate.sq_distance);
+            }
+        }
+        tile.assignment.solve(exactAssignment(tile.assignment.candidates()));
+        for(int k = begin; k < end; ++k){
+            const int column = tile.assignment.assignedColumn(k - begin);
+            local_assigned_[tile_tracks_[k]] = (column == -1) ? -1 : tile.points[column];
+        }
+    };
+    worker_pool_->parallelFor(tile_count, solveTile);
+    for(int i = 0; i < count; ++i){
+        if(local_assigned_[i] != -1)
+            frame_index_->take(local_assigned_[i]);
+    }
 
-            last_point.x_statistics.confidence_interval = ( last_point.x_statistics.confidence_interval < (loaded_params_->max_px_shift.x)) ? (loaded_params_->max_px_shift.x) : last_point.x_statistics.confidence_interval;
-            last_point.y_statistics.confidence_interval = ( last_point.y_statistics.confidence_interval < (loaded_params_->max_px_shift.x)) ? (loaded_params_->max_px_shift.x) : last_point.y_statistics.confidence_interval;
+    // halo conflicts: the sequences at the borders get the points left by the tiles, in one batch
+    assignment_.reset(frame_index_->size());
+    int border_tracks = 0;
+    for(int i = 0; i < count; ++i){
+        if(track_tile_[i] != -1)
+            continue;
+        const Track& seq = track_pool_[gen_sequences_[i]];
+        const cv::Point2d last_inserted(seq.x(seq.size() - 1), seq.y(seq.size() - 1));
+        assignment_.addRow(seq.trackId());
+        addAssignmentCandidates(last_inserted, last_inserted - shift, last_inserted + shift);
+        track_tile_[border_tracks++] = i; // the sequence of each row, the tiles are not needed anymore
+    }
+    solveAssignment();
+    for(int row = 0; row < border_tracks; ++row){
+        const int point = assignment_.assignedColumn(row);
+        local_assigned_[track_tile_[row]] = point;
+        if(point != -1)
+            frame_index_->take(point);
+    }
+}
 
+void AMI::extendedSearch(std::vector<TrackHandle>& sequences_no_insert){
+    std::scoped_lock lock(mutex_gen_sequences_);
+    AMI_STAGE_TIMER(instrumentation_, Stage::extended_search);
+
+    if(frame_index_->remaining() != 0){
+        const int64_t frame_stamp_ns = frame_stamp_ns_;
+        const int count = (int)sequences_no_insert.size();
+        search_windows_.resize(count);
+        AMI_COUNT(instrumentation_, extended_search_queries, count);
+
+        // load shedding: only as many regressions as fit into half of the remaining budget, the rest of the frame needs time as well
+        int predictions = count;
+        const int64_t remaining_ns = remainingBudgetNs();
+        if(remaining_ns <= 0){
+            predictions = 0;
+        }else if(remaining_ns != std::numeric_limits<int64_t>::max() && prediction_cost_ns_ > 0.0){
+            predictions = (int)std::min<double>(count, 0.5 * remaining_ns / prediction_cost_ns_);
+        }
+        for(auto& window : search_windows_)
+            window.fallback = false;
+        if(predictions < count){
+            search_priorities_.clear();
+            for(int i = 0; i < count; ++i)
+                search_priorities_.emplace_back(-searchPriority(track_pool_[sequences_no_insert[i]]), i);
+            if(predictions > 0)
+                std::nth_element(search_priorities_.begin(), search_priorities_.begin() + (predictions - 1), search_priorities_.end());
+            for(int k = predictions; k < count; ++k)
+                search_windows_[search_priorities_[k].second].fallback = true;
+            degradation_.level = (predictions == 0) ? DegradationLevel::local_only : DegradationLevel::reduced_prediction;
+            degradation_.fallback_sequences = count - predictions;
+            AMI_COUNT(instrumentation_, fallback_searches, count - predictions);
+        }
 
-            double x_conf = last_point.x_statistics.confidence_interval;
-            double y_conf = last_point.y_statistics.confidence_interval; 
-             
-            cv::Point2d bb_left_top = cv::Point2d( (x_predicted - x_conf), (y_predicted - y_conf) );
-            cv::Point2d bb_right_bottom = cv::Point2d( (x_predicted + x_conf), (y_predicted + y_conf) );
-            
-            if(debug_){
-                std::cout << "[AMI]: Predicted Point: x = " << x_predicted << " y = " << y_predicted << " Prediction Interval: x = " << x_conf << " y = " << y_conf << " seq_size " << x.size();
-                std::cout << "\n";
-            }
+        auto predict = [&](int i){
+            predictSearchWindow(track_pool_[sequences_no_insert[i]], frame_stamp_ns, search_windows_[i]);
+        };
+        {
+        AMI_STAGE_TIMER(instrumentation_, Stage::regression);
+        const int64_t prediction_start_ns = (current_budget_ns_ > 0) ? steadyClockNs() : 0;
+        if(worker_pool_ && count >= loaded_params_->parallel_search_threshold){
+            worker_pool_->parallelFor(count, predict);
+        }else{
+            for(int i = 0; i < count; ++i)
+                predict(i);
+        }
+        if(current_budget_ns_ > 0 && predictions > 0){
+            const double cost_ns = double(steadyClockNs() - prediction_start_ns) / predictions;
+            prediction_cost_ns_ = (prediction_cost_ns_ > 0.0) ? 0.9 * prediction_cost_ns_ + 0.1 * cost_ns : cost_ns;
+        }
+        }
 
-            double closest_distance = std::numeric_limits<double>::max();
-            std::vector<PointState>::iterator selected_it = no_nn_current_frame.end();
-            for(auto it_frame = no_nn_current_frame.begin(); it_frame != no_nn_current_frame.end(); ++it_frame){
+        // the remaining points are assigned to the predicted windows in one batch, sequences without a window get no candidates
+        assignment_.reset(frame_index_->size());
+        for(int i = 0; i < count; ++i){
+            const TrackHandle handle = sequences_no_insert[i];
+            Track& track = track_pool_[handle];
+            assignment_.addRow(track.trackId());
+            const SearchWindow& window = search_windows_[i];
+            if(!window.computed)
+                continue;
 
-                double curr_dist = extended_search_->euclideanDistance((*it_frame).point, last_point.point);
-                if(curr_dist <= closest_distance){
-                    closest_distance = curr_dist; 
-                    selected_it = it_frame;
-                }
-            }
+            AMI_TRACE(instrumentation_, tracing(), TraceEventType::prediction, frame_stamp_ns, handle.index, track.xStatistics().predicted_coordinate, track.yStatistics().predicted_coordinate,
+                      track.xStatistics().confidence_interval, track.yStatistics().confidence_interval, track.predictionCache().n, 0);
 
-            if(selected_it != no_nn_current_frame.end()){
-                if( extended_search_->isInsideBB( (*selected_it).point, bb_left_top, bb_right_bottom ) ){
-                    selected_it->x_statistics = last_point.x_statistics;
-                    selected_it->y_statistics = last_point.y_statistics;
-                    insertPointToSequence(*(*it_seq), *selected_it);
-                    selected_it = no_nn_current_frame.erase(selected_it);
-                    it_seq = sequences_no_insert.erase(it_seq); 
-                }else{
-                    ++it_seq;
-                }
+            const cv::Point2d last_point(track.x(track.size() - 1), track.y(track.size() - 1));
+            addAssignmentCandidates(last_point, window.left_top, window.right_bottom);
+        }
+        solveAssignment();
+
+        int kept = 0;
+        for(int i = 0; i < count; ++i){
+            const TrackHandle handle = sequences_no_insert[i];
+            const int selected = assignment_.assignedColumn(i);
+            if(selected != -1){
+                Track& track = track_pool_[handle];
+                // the prediction statistics of the track now belong to the inserted point
+                insertPointToSequence(track, frameSample(selected));
+                frame_index_->take(selected);
+                AMI_COUNT(instrumentation_, extended_search_hits, 1);
+                recordEvent(TrackEventType::position_updated, handle, track);
+                AMI_TRACE(instrumentation_, tracing(), TraceEventType::extended_search_hit, frame_stamp_ns, handle.index, track.x(track.size() - 1), track.y(track.size() - 1), 0, 0, 0, 0);
             }else{
-                ++it_seq;
+                sequences_no_insert[kept++] = handle;
             }
         }
-
+        sequences_no_insert.resize(kept);
     }
 
 
     // for sequences with no newly inserted point, add virtual point
-    for(auto seq : sequences_no_insert){
-        insertVPforSequencesWithNoInsert(seq);
+    for(const auto& handle : sequences_no_insert){
+        insertVPforSequencesWithNoInsert(track_pool_[handle]);
     }
 
-    // delete the sequences that are over the max_buffer_length. Elements are deleted from the back of sequence vector
-    if(loaded_params_->max_buffer_length < (int)gen_sequences_.size()){
-        ROS_ERROR("[AMI]: The maximal excepted buffer length of %d is reached! %d points will be discarded. Please consider to set the parameter \"_max_buffer_length_\" higher, if the memory has the capacity.", loaded_params_->max_buffer_length, (int)no_nn_current_frame.size());
-
-        int diff = (int)gen_sequences_.size() - loaded_params_->max_buffer_length;
-        for(int i = 0; i < diff; ++i){
-            gen_sequences_.erase(gen_sequences_.end() - 1); 
+    // for the points, still no NN found -> start new sequence
+    int discarded = 0;
+    for(int i = 0; i < frame_index_->size(); ++i){
+        if(frame_index_->isTaken(i))
+            continue;
+        TrackHandle handle = track_pool_.acquire();
+        if(!handle.valid()){
+            discarded++;
+            continue;
         }
-        return;
+        Track& track = track_pool_[handle];
+        track.setTrackId(next_track_id_++);
+        insertPointToSequence(track, frameSample(i));
+        gen_sequences_.push_back(handle);
+        recordEvent(TrackEventType::created, handle, track);
+        AMI_COUNT(instrumentation_, created_tracks, 1);
+        AMI_TRACE(instrumentation_, tracing(), TraceEventType::track_created, frame_stamp_ns_, handle.index, frame_index_->point(i).x, frame_index_->point(i).y, 0, 0, 0, 0);
     }
 
-    // for the points, still no NN found -> start new sequence
-    for(auto point : no_nn_current_frame){
-        std::vector<PointState> vect;
-        vect.reserve(loaded_params_->stored_seq_len_factor*original_sequences_[0].size());
-        vect.emplace_back(point);
-        gen_sequences_.emplace_back(std::make_shared<std::vector<PointState>>(vect));
+    // the pool holds at most max_buffer_length sequences
+    if(discarded > 0){
+        AMI_COUNT(instrumentation_, dropped_points, discarded);
+        AMI_TRACE(instrumentation_, tracing(), TraceEventType::points_dropped, frame_stamp_ns_, TrackHandle::invalid_index, 0, 0, 0, 0, discarded, 0);
+        AMI_LOG_ERROR("[AMI]: The maximal excepted buffer length of %d is reached! %d points will be discarded. Please consider to set the parameter \"_max_buffer_length_\" higher, if the memory has the capacity.", loaded_params_->max_buffer_length, discarded);
     }
 
 }
 
-void AMI::insertPointToSequence(std::vector<PointState> & sequence, const PointState signal){
-    sequence.push_back(signal);            
-    if(sequence.size() > (original_sequences_[0].size()* loaded_params_->stored_seq_len_factor)){
-        sequence.erase(sequence.begin());
-    }
+void AMI::addAssignmentCandidates(const cv::Point2d& anchor, const cv::Point2d& left_top, const cv::Point2d& right_bottom){
+
+    box_candidates_.clear();
+    frame_index_->candidatesInBox(anchor, left_top, right_bottom, box_candidates_);
+    for(const auto& candidate : box_candidates_)
+        assignment_.addCandidate(candidate.index, candidate.sq_distance);
 }
 
-void AMI::insertVPforSequencesWithNoInsert(seqPointer & seq){
-    PointState pVirtual;
-    pVirtual = seq->end()[-1];
-    pVirtual.insert_time = ros::Time::now();
-    pVirtual.led_state = false;
-    insertPointToSequence(*seq, pVirtual);
+bool AMI::exactAssignment(const size_t& candidates){
+
+    // very large frames and frames over their budget are assigned greedily by cost
+    const bool exact = (int64_t)candidates <= loaded_params_->assignment_exact_limit && remainingBudgetNs() >= 0;
+    if(!exact)
+        AMI_COUNT(instrumentation_, greedy_assignments, 1);
+    return exact;
 }
 
-PredictionStatistics AMI::selectStatisticsValues(const std::vector<double>& values, const std::vector<double>& time, const double& insert_time){
+void AMI::solveAssignment(){
 
-    auto weight_vect = extended_search_->calcNormalizedWeightVect(time);
-    
-    PredictionStatistics statistics;
-    statistics.mean_independent = extended_search_->calcWeightedMean(time, weight_vect); 
-    statistics.time_pred = insert_time;
-    statistics.poly_reg_computed = false;
-    int poly_order = loaded_params_->poly_order;
+    assignment_.solve(exactAssignment(assignment_.candidates()));
+}
+
+void AMI::predictSearchWindow(Track& track, const int64_t& frame_stamp_ns, SearchWindow& window){
 
-    if( 0 < (int)values.size() && (int)values.size() < poly_order ){
-        poly_order = values.size() - 2;
+    window.computed = false;
+    if(track.empty())
+        return;
+
+    if(window.fallback){
+        const cv::Point2d last_point(track.x(track.size() - 1), track.y(track.size() - 1));
+        const cv::Point2d shift(loaded_params_->max_px_shift.x * 2, loaded_params_->max_px_shift.y * 2);
+        track.resetStatistics();
+        window.computed = true;
+        window.left_top = last_point - shift;
+        window.right_bottom = last_point + shift;
+        return;
     }
 
-    if((int)values.size() > 1){
+    PredictionStatistics x_predictions, y_predictions;
+    bool fitted;
+    const bool predicted = predictor_->predict(track, frame_stamp_ns, x_predictions, y_predictions, fitted);
+    if(fitted)
+        AMI_COUNT(instrumentation_, regression_fits, 1);
+    if(!predicted)
+        return;
+    window.computed = true;
 
-        auto [coeff, predicted_vals_past] = extended_search_->polyReg(values, time, weight_vect, poly_order);
-        statistics.coeff = coeff;
-        statistics.predicted_vals_past = predicted_vals_past;
+    PredictionStatistics& x_statistics = track.xStatistics();
+    PredictionStatistics& y_statistics = track.yStatistics();
+    x_statistics = x_predictions;
+    y_statistics = y_predictions;
+    double x_predicted = x_statistics.predicted_coordinate;
+    double y_predicted = y_statistics.predicted_coordinate;
 
-        bool all_coeff_zero = std::all_of(coeff.begin(), coeff.end(), [](double coeff){return coeff == 0.0;});
-        if(!all_coeff_zero){ 
-            for(int i = 0; i < (int)coeff.size(); ++i){
-                statistics.predicted_coordinate += coeff[i]*pow(insert_time, i);
-            }
-        }
 
-        statistics.confidence_interval = extended_search_->confidenceInterval(statistics, time, values, weight_vect, loaded_params_->conf_probab_percent);
-        statistics.poly_reg_computed = true;
-    }
-        
-    statistics.extended_search = true;
-    return statistics;
+    x_statistics.confidence_interval = ( x_statistics.confidence_interval > (loaded_params_->max_px_shift.x * 2) ) ? (loaded_params_->max_px_shift.x * 2) : x_statistics.confidence_interval;
+    y_statistics.confidence_interval = ( y_statistics.confidence_interval > (loaded_params_->max_px_shift.y * 2) ) ? (loaded_params_->max_px_shift.y * 2) : y_statistics.confidence_interval;
+
+    x_statistics.confidence_interval = ( x_statistics.confidence_interval < (loaded_params_->max_px_shift.x)) ? (loaded_params_->max_px_shift.x) : x_statistics.confidence_interval;
+    y_statistics.confidence_interval = ( y_statistics.confidence_interval < (loaded_params_->max_px_shift.x)) ? (loaded_params_->max_px_shift.x) : y_statistics.confidence_interval;
+
+
+    double x_conf = x_statistics.confidence_interval;
+    double y_conf = y_statistics.confidence_interval; 
+     
+    window.left_top = cv::Point2d( (x_predicted - x_conf), (y_predicted - y_conf) );
+    window.right_bottom = cv::Point2d( (x_predicted + x_conf), (y_predicted + y_conf) );
+}
+
+TrackSample AMI::frameSample(const int& index) const{
+    const cv::Point2d& point = frame_index_->point(index);
+    return TrackSample{(float)point.x, (float)point.y, frame_stamp_ns_, true};
+}
+
+void AMI::insertPointToSequence(Track & sequence, const TrackSample& signal){
+    predictor_->insert(sequence, signal);
+}
+
+void AMI::insertVPforSequencesWithNoInsert(Track & seq){
+    TrackSample pVirtual = seq.sample(seq.size() - 1);
+    pVirtual.stamp_ns = now_ns_;
+    pVirtual.led_state = false;
+    insertPointToSequence(seq, pVirtual);
 }
 
 void AMI::cleanPotentialBuffer(){
 
     std::scoped_lock lock(mutex_gen_sequences_);
-    for( auto it_seq = gen_sequences_.begin(); it_seq != gen_sequences_.end();){
-        bool deleted = false;
-        int number_zeros_till_seq_deleted = (loaded_params_->max_zeros_consecutive + loaded_params_->allowed_BER_per_seq);
-        if((int)((*it_seq)->size()) > number_zeros_till_seq_deleted){
-            int cnt = 0;
-            for(auto it_seq_element : *(*it_seq)){
-                if(!it_seq_element.led_state){
-                    cnt++;
-                    if(cnt > number_zeros_till_seq_deleted)
-                        break;
-                }else{
-                    cnt = 0;
-                }
-            }
-            if(cnt > number_zeros_till_seq_deleted){
-                deleted = true;
-                it_seq = gen_sequences_.erase(it_seq);
-                continue;
-            }
+    AMI_STAGE_TIMER(instrumentation_, Stage::pruning);
+    const int number_zeros_till_seq_deleted = (loaded_params_->max_zeros_consecutive + loaded_params_->allowed_BER_per_seq);
+
+    // a run of "off"-points can only grow at the end of a sequence and the buffer is cleaned after every frame, so checking the trailing run is sufficient.
+    // The sequences are compacted in one pass, the order of the remaining ones is kept - they stay ordered by their track id
+    int kept = 0;
+    for(const auto& handle : gen_sequences_){
+        if(track_pool_[handle].consecutiveZeros() > number_zeros_till_seq_deleted){
+            AMI_TRACE(instrumentation_, tracing(), TraceEventType::track_pruned, frame_stamp_ns_, handle.index, 0, 0, 0, 0, track_pool_[handle].size(), 0);
+            recordEvent(TrackEventType::lost, handle, track_pool_[handle]);
+            track_pool_.release(handle);
+        }else{
+            gen_sequences_[kept++] = handle;
         }
-        if(!deleted)++it_seq;
     }
+    AMI_COUNT(instrumentation_, pruned_tracks, gen_sequences_.size() - kept);
+    gen_sequences_.resize(kept);
 }
 
-std::vector<std::pair<seqPointer, int>> AMI::getResults(){
+void AMI::publishResults(){
 
     std::scoped_lock lock(mutex_gen_sequences_);
-    std::vector<std::pair<seqPointer, int>> retrieved_signals;
-    if(debug_) std::cout << "[AMI]: The retrieved signals:{\n";
-    for (auto sequence : gen_sequences_){
-        std::vector<bool> led_states;
-
-        std::vector<PointState> selected;
-        if ((int)(*sequence).size() > (int)original_sequences_[0].size()){
-            int diff = (int)(*sequence).size() - (int)original_sequences_[0].size();
-            for(int i = diff; i < (int)(*sequence).size(); ++i){
-                selected.push_back((*sequence)[i]);
-            }
-        }else{
-            selected = *sequence;
+    AMI_STAGE_TIMER(instrumentation_, Stage::matching);
+    ResultSnapshot& snapshot = results_.back();
+    snapshot.stamp_ns = frame_stamp_ns_;
+    snapshot.frame_number = processed_frames_;
+    snapshot.degradation = degradation_;
+    snapshot.tracks.clear();
+    for (const auto& handle : gen_sequences_){
+        Track& sequence = track_pool_[handle];
+
+        // the id only changes if a new point was pushed to the sequence
+        int id;
+        if(!sequence.cachedSignalId(id)){
+            const int previous_id = id;
+            id = tables_->matchSignal(sequence);
+            sequence.setSignalId(id);
+            if(id != previous_id)
+                recordEvent(TrackEventType::identity_changed, handle, sequence, previous_id);
+            AMI_TRACE(instrumentation_, tracing(), TraceEventType::match, frame_stamp_ns_, handle.index, 0, 0, 0, 0, id, sequence.ledHistory());
+        }
+        TrackResult result;
+        result.handle = handle;
+        result.track_id = sequence.trackId();
+        result.id = id;
+        result.last_point = sequence.back();
+        result.x_statistics = sequence.xStatistics();
+        result.y_statistics = sequence.yStatistics();
+        result.led_history = sequence.ledHistory();
+        result.sequence_size = sequence.size();
+        snapshot.tracks.push_back(result);
+    }
+    results_.publish();
+}
+
+const ResultSnapshot& AMI::getResults(){
+
+    const ResultSnapshot& snapshot = results_.read();
+    return snapshot;
+}
+
+void AMI::recordEvent(const TrackEventType& type, const TrackHandle& handle, const Track& track, const int& previous_id){
+    if(!events_.enabled())
+        return;
+    int id;
+    track.cachedSignalId(id);
+    const int newest = track.size() - 1;
+    events_.record(TrackEvent{type, track.trackId(), handle, frame_stamp_ns_, track.x(newest), track.y(newest), id, (type == TrackEventType::identity_changed) ? previous_id : id});
+}
+
+bool AMI::pollEvents(std::vector<TrackEvent>& events){
+    return events_.poll(events);
+}
+
+bool AMI::getSequence(const TrackHandle& handle, std::vector<PointState>& points){
+    std::scoped_lock lock(mutex_gen_sequences_);
+    const Track* sequence = track_pool_.get(handle);
+    if(sequence == nullptr)
+        return false;
+    points.assign(sequence->begin(), sequence->end());
+    return true;
+}
+
+TrackPoolStatistics AMI::getPoolStatistics(){
+    std::scoped_lock lock(mutex_gen_sequences_);
+    return track_pool_.statistics();
+}
+
+AMI::~AMI() {
+    if(frame_queue_){
+        frame_queue_->stop();
+        tracker_thread_.join();
+    }
+}
+
+TrackerStatistics AMI::getStatistics(){
+    TrackerStatistics statistics;
+    instrumentation_.statistics(statistics);
+    std::scoped_lock lock(mutex_gen_sequences_);
+    statistics.active_tracks = (int)gen_sequences_.size();
+    statistics.memory_bytes = track_pool_.memoryBytes() + frame_index_->memoryBytes() + gen_sequences_.capacity() * sizeof(TrackHandle) + sequences_no_insert_.capacity() * sizeof(TrackHandle) + search_windows_.capacity() * sizeof(SearchWindow) + assignment_.memoryBytes();
+    return statistics;
+}
+
+void AMI::resetStatistics(){
+    instrumentation_.reset();
+}
+
+bool AMI::dumpTrace(const std::string& path) const{
+    return instrumentation_.traceRing().dump(path);
+}
+
+void AMI::saveSnapshot(std::vector<uint8_t>& buffer){
+
+    buffer.clear();
+    SnapshotWriter writer(buffer);
+    SnapshotHeader header{};
+    std::memcpy(header.magic, "AMISNAP", sizeof(header.magic));
+    header.version = snapshot_version;
+    header.layout = Track::snapshotLayout();
+    writer.write(header);
+
+    const loadedParamsForAMI& p = *loaded_params_;
+    writer.write(SnapshotParams{p.max_px_shift.x, p.max_px_shift.y, p.max_zeros_consecutive, p.stored_seq_len_factor, p.max_buffer_length, p.poly_order, p.decay_factor,
+                                p.conf_probab_percent, p.allowed_BER_per_seq, (int32_t)p.predictor_mode, p.kalman_process_noise, p.kalman_measurement_noise});
+    {
+        // between two frames: every track got the point or the "off"-sample of the last frame and the pruning is done
+        std::scoped_lock lock(mutex_frame_, mutex_gen_sequences_);
+        const uint32_t sequence_count = tables_ ? (uint32_t)tables_->sequences().size() : 0;
+        writer.write(sequence_count);
+        for(uint32_t i = 0; i < sequence_count; ++i){
+            const std::vector<bool>& sequence = tables_->sequences()[i];
+            writer.write((uint32_t)sequence.size());
+            for(bool bit : sequence)
+                writer.write((uint8_t)bit);
         }
-        for (auto point : selected){
-            led_states.push_back(point.led_state);        
+        writer.write(SnapshotState{next_track_id_, frame_stamp_ns_, now_ns_, processed_frames_, (uint32_t)gen_sequences_.size()});
+        for(const auto& handle : gen_sequences_)
+            track_pool_[handle].save(writer);
+    }
+    header.payload_size = writer.size() - sizeof(header);
+    header.checksum = snapshotChecksum(writer.data() + sizeof(header), header.payload_size);
+    std::memcpy(writer.data(), &header, sizeof(header));
+}
+
+bool AMI::writeSnapshot(const std::string& path){
+
+    std::scoped_lock lock(mutex_snapshot_);
+    saveSnapshot(snapshot_buffer_);
+    const std::string tmp_path = path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        if(!file)
+            return false;
+        file.write(reinterpret_cast<const char*>(snapshot_buffer_.data()), snapshot_buffer_.size());
+        if(!file)
+            return false;
+    }
+    return std::rename(tmp_path.c_str(), path.c_str()) == 0;
+}
+
+bool AMI::restoreSnapshot(const uint8_t* data, const size_t& size){
+
+    std::scoped_lock frame_lock(mutex_frame_);
+    SnapshotReader reader(data, size);
+    SnapshotHeader header;
+    if(!reader.read(header) || std::memcmp(header.magic, "AMISNAP", sizeof(header.magic)) != 0 || header.payload_size != reader.remaining()){
+        AMI_LOG_ERROR("[AMI]: The snapshot is damaged. The tracks are not restored.");
+        return false;
+    }
+    if(header.version != snapshot_version || header.layout != Track::snapshotLayout()){
+        AMI_LOG_ERROR("[AMI]: The snapshot was written by a different version of the tracker. The tracks are not restored.");
+        return false;
+    }
+    if(header.checksum != snapshotChecksum(data + sizeof(header), header.payload_size)){
+        AMI_LOG_ERROR("[AMI]: The snapshot is damaged (checksum). The tracks are not restored.");
+        return false;
+    }
+
+    // the stored tracks carry the window length, regressions and filter states of these parameters
+    SnapshotParams stored;
+    if(!reader.read(stored)){
+        AMI_LOG_ERROR("[AMI]: The snapshot is damaged. The tracks are not restored.");
+        return false;
+    }
+    const loadedParamsForAMI& p = *loaded_params_;
+    if(stored.stored_seq_len_factor != p.stored_seq_len_factor || stored.predictor_mode != (int32_t)p.predictor_mode || stored.poly_order != p.poly_order ||
+       stored.decay_factor != p.decay_factor || stored.kalman_process_noise != p.kalman_process_noise || stored.kalman_measurement_noise != p.kalman_measurement_noise){
+        AMI_LOG_ERROR("[AMI]: The snapshot was written with different regression or predictor parameters. The tracks are not restored.");
+        return false;
+    }
+
+    uint32_t sequence_count = 0;
+    bool complete = reader.read(sequence_count);
+    std::vector<std::vector<bool>> sequences;
+    for(uint32_t i = 0; i < sequence_count && complete; ++i){
+        uint32_t length = 0;
+        // the length is checked before the allocation, a damaged length must not allocate gigabytes
+        complete = reader.read(length) && length <= reader.remaining();
+        if(!complete)
+            break;
+        std::vector<uint8_t> bits(length);
+        complete = reader.readArray(bits.data(), length);
+        sequences.emplace_back(bits.begin(), bits.end());
+    }
+    SnapshotState state;
+    if(!complete || !reader.read(state)){
+        AMI_LOG_ERROR("[AMI]: The snapshot is damaged. The tracks are not restored.");
+        return false;
+    }
+    std::shared_ptr<const SequenceTables> tables = tables_;
+    if(!tables){
+        if(sequences.empty()){
+            AMI_LOG_ERROR("[AMI]: The snapshot holds no sequences. The tracks are not restored.");
+            return false;
         }
-        if(debug_){
-            std::cout << "[ ";
-            for(auto state : led_states){
-                if(state) std::cout << "1,";
-                else std::cout << "0,";
-            }
-            std::cout << "]\n";
+        tables = std::make_shared<const SequenceTables>(sequences, loaded_params_->allowed_BER_per_seq, loaded_params_->stored_seq_len_factor, loaded_params_->decay_factor, loaded_params_->conf_probab_percent);
+    }else if(tables->sequences() != sequences){
+        AMI_LOG_ERROR("[AMI]: The snapshot was written with different sequences. The tracks are not restored.");
+        return false;
+    }
+
+    // all tracks are parsed before the tracker is touched, a damaged record keeps the current tracks
+    const size_t max_tracks = (size_t)std::max(loaded_params_->max_buffer_length, 0);
+    std::vector<Track> staged;
+    staged.reserve(std::min<size_t>(state.track_count, max_tracks));
+    std::unique_ptr<Track> overflow; // reads the tracks that do not fit into the pool
+    int discarded = 0;
+    for(uint32_t i = 0; i < state.track_count && complete; ++i){
+        if(staged.size() < max_tracks){
+            staged.emplace_back(tables->trackCapacity());
+            complete = staged.back().load(reader);
+            continue;
         }
+        if(!overflow)
+            overflow = std::make_unique<Track>(tables->trackCapacity());
+        discarded++;
+        complete = overflow->load(reader);
+    }
+    if(!complete || reader.remaining() != 0){
+        AMI_LOG_ERROR("[AMI]: The snapshot is damaged. The tracks are not restored.");
+        return false;
+    }
 
-        int id = matcher_->matchSignal(led_states);
-        auto sequence_copy = sequence; 
-        retrieved_signals.push_back(std::make_pair(sequence_copy, id));
+    if(tables != tables_ && !setSequences(tables))
+        return false;
+    {
+        std::scoped_lock lock(mutex_gen_sequences_);
+        for(const auto& handle : gen_sequences_){
+            recordEvent(TrackEventType::lost, handle, track_pool_[handle]);
+            track_pool_.release(handle);
+        }
+        gen_sequences_.clear();
+
+        frame_stamp_ns_ = state.frame_stamp_ns;
+        now_ns_ = state.now_ns;
+        processed_frames_ = state.processed_frames;
+        next_track_id_ = state.next_track_id;
+        for(Track& track : staged){
+            // the pool holds max_buffer_length tracks, all of them were released above
+            const TrackHandle handle = track_pool_.acquire();
+            std::swap(track_pool_[handle], track);
+            gen_sequences_.push_back(handle);
+            recordEvent(TrackEventType::created, handle, track_pool_[handle]);
+        }
+        events_.commit();
     }
-    if(debug_)std::cout << "}\n";
-    
-    return retrieved_signals;
+    if(discarded > 0){
+        AMI_LOG_WARN("[AMI]: The snapshot holds more sequences than \"_max_buffer_length_\", %d sequences were not restored.", discarded);
+    }
+    publishResults();
+    return true;
 }
 
-AMI::~AMI() {
-}
\ No newline at end of file
+bool AMI::readSnapshot(const std::string& path){
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file)
+        return false;
+    std::vector<uint8_t> data((size_t)file.tellg());
+    file.seekg(0);
+    if(!file.read(reinterpret_cast<char*>(data.data()), data.size()))
+        return false;
+    return restoreSnapshot(data.data(), data.size());
+}
@@ -1,24 +1,21 @@
 #pragma once
 
-#include "ami_extended_search.h"
-#include <uvdar_core/ImagePointsWithFloatStamped.h>
-#include "signal_matcher/signal_matcher.h"
+#include "ami_predictor.h"
+#include "ami_spatial_grid.h"
+#include "ami_track_pool.h"
+#include "ami_triple_buffer.h"
+#include "ami_worker_pool.h"
+#include "ami_clock.h"
+#include "ami_instrumentation.h"
+#include "ami_frame_queue.h"
+#include "ami_track_events.h"
+#include "ami_frame_log.h"
+#include "ami_assignment.h"
+#include "ami_log.h"
 
 namespace uvdar
 {
 
-    struct PointState{
-        cv::Point2d point;
-        bool led_state; 
-        ros::Time insert_time;
-
-        PredictionStatistics x_statistics;
-        PredictionStatistics y_statistics;
-        
-    };
-    
-    using seqPointer = std::shared_ptr<std::vector<PointState>>;
-
     // loaded params from the launch file and passed to the AMI
     struct loadedParamsForAMI{
         cv::Point max_px_shift;
@@ -29,73 +26,268 @@ namespace uvdar
         double decay_factor;
         double conf_probab_percent;
         int allowed_BER_per_seq;
+        PredictorMode predictor_mode = PredictorMode::poly_regression;
+        double kalman_process_noise = 1e4; // Kalman modes: spectral density of the white acceleration (px^2/s^3, constant velocity) or white jerk (px^2/s^5, constant acceleration)
+        double kalman_measurement_noise = 0.25; // Kalman modes: variance of a measured coordinate in px^2
+        int worker_threads = 0; // threads for the predictions of the extended search besides the processing thread, 0 computes all predictions in the processing thread
+        int parallel_search_threshold = 32; // minimal number of sequences in the extended search to compute the predictions in parallel
+        int async_queue_length = 0; // number of frames queued for the tracker thread, 0 processes the frames in the calling thread
+        BackpressurePolicy backpressure_policy = BackpressurePolicy::block; // behaviour of submitFrame() if the queue is full
+        double frame_budget_fraction = 0.0; // share of the frame period (updateFramerate()) available for processing a frame, 0 disables the load shedding
+        int event_queue_length = 0; // maximal number of track events kept between two pollEvents(), 0 disables the events
+        int assignment_exact_limit = 65536; // candidate (sequence, point) pairs up to which a search is assigned optimally, larger ones are assigned greedily by distance
+        int local_search_tile_size = 0; // side in px of the tiles of the parallel local search (with "worker_threads" and at least "parallel_search_threshold" sequences), 0 searches serially
+    };
+
+    enum class DegradationLevel{
+        none,
+        reduced_prediction, // only the sequences with the highest priority got a regression, the others were searched in the fallback box around their last point
+        local_only // the budget was exhausted before the extended search, no regression was computed
+    };
+
+    // load shedding applied to one frame
+    struct FrameDegradation{
+        DegradationLevel level = DegradationLevel::none;
+        int fallback_sequences = 0; // sequences of the extended search that were searched in the fallback box
+        bool pruning_deferred = false; // cleanPotentialBuffer() was skipped for this frame
+    };
+
+    // retrieved sequence passed to the bp_tim.cpp
+    struct TrackResult{
+        TrackHandle handle; // stable identifier of the sequence, can be used with AMI::getSequence()
+        uint64_t track_id; // same as TrackEvent::track_id
+        int id; // id of the matched original sequence, -1 if none matches
+        PointState last_point;
+        PredictionStatistics x_statistics;
+        PredictionStatistics y_statistics;
+        uint64_t led_history; // newest led states, bit 0 is the newest point
+        int sequence_size; // number of stored points
+    };
+
+    // immutable results of one processed frame
+    struct ResultSnapshot{
+        int64_t stamp_ns = 0; // time stamp of the frame
+        uint64_t frame_number = 0; // number of processed frames, 0 if no frame was processed yet
+        FrameDegradation degradation; // load shedding applied to the frame
+        std::vector<TrackResult> tracks;
     };
 
     class AMI {
     
     private:
-        bool debug_ = false;
+        std::atomic<bool> debug_{false}; // set by setDebugFlags() after the trace ring is allocated, read by the thread that processes the frames
+
+        // acquire: a thread that sees the debug flag also sees the allocated trace ring
+        bool tracing() const { return debug_.load(std::memory_order_acquire); }
 
         std::unique_ptr<loadedParamsForAMI> loaded_params_ = std::make_unique<loadedParamsForAMI>();
 
-        double framerate_;
-        const double prediction_margin_ = 0.0;
-        std::vector<std::vector<bool>> original_sequences_;
+        double framerate_ = 0.0;
+        std::shared_ptr<const SequenceTables> tables_; // matching and t-quantile tables of the original sequences, may be shared with other trackers
+        std::unique_ptr<Predictor> predictor_; // selected by "predictor_mode", created with the tables
+        int track_capacity_ = 0; // number of points stored per sequence: length of the sequence * stored_seq_len_factor
+        std::mutex mutex_frame_; // held for a whole frame - a snapshot is never taken or restored in the middle of a frame
         std::mutex mutex_gen_sequences_;
-        std::vector<seqPointer> gen_sequences_;
-        std::unique_ptr<SignalMatcher> matcher_;
-        std::unique_ptr<ExtendedSearch> extended_search_;
+        TrackPool track_pool_; // storage of all generated sequences, sized by max_buffer_length
+        std::vector<TrackHandle> gen_sequences_;
+        int64_t frame_stamp_ns_ = 0; // time stamp of the frame that is currently processed
+        int64_t now_ns_ = 0; // time of the clock when the current frame is processed
+        std::unique_ptr<Clock> clock_ = std::make_unique<FrameClock>();
+        std::vector<TrackHandle> sequences_no_insert_; // reused for every frame
+        TripleBuffer<ResultSnapshot> results_; // written at the end of processFrame(), read by getResults()
+        uint64_t processed_frames_ = 0;
+        uint64_t next_track_id_ = 1;
+        TrackEventBuffer events_; // changes of the tracks for pollEvents(), only filled with "event_queue_length"
+        std::mutex mutex_snapshot_;
+        std::vector<uint8_t> snapshot_buffer_; // reused by writeSnapshot()
+        std::mutex mutex_recorder_;
+        std::atomic<bool> recording_{false};
+        FrameLogWriter recorder_; // frames of submitFrame(), for replay with FrameLogReader
+        std::unique_ptr<SpatialGrid> frame_index_; // index over the points of the frame that is currently processed
+        std::shared_ptr<WorkerPool> worker_pool_; // nullptr if the predictions are always computed serially, may be shared with other trackers
+
+        // load shedding - only active with a framerate and "frame_budget_fraction"
+        static constexpr int max_deferred_prunings_ = 4; // cleanPotentialBuffer() is run at least every max_deferred_prunings_ + 1 frames
+        std::atomic<int64_t> frame_budget_ns_{0}; // 0 if there is no budget
+        int64_t frame_start_ns_ = 0; // steady clock at the start of the current frame
+        int64_t current_budget_ns_ = 0; // budget of the current frame, taken from frame_budget_ns_ at the start of the frame
+        double prediction_cost_ns_ = 0.0; // moving average of the time of one prediction in the extended search
+        int deferred_prunings_ = 0;
+        FrameDegradation degradation_; // of the current frame
+        std::vector<std::pair<int, int>> search_priorities_; // (priority, index) of the sequences in the extended search, reused for every frame
+
+        /**
+         * @brief remaining time of the frame budget
+         * @return std::numeric_limits<int64_t>::max() if there is no budget
+         */
+        int64_t remainingBudgetNs() const;
 
         /**
-         * @brief check if distance between the last point in the sequences and point in current frame is within the "max_px_shift" allowed distance. If yes, point in current frame is inserted otherwise point is pushed into vector for expandedSearch()
-         * @param current_frame vector of points in the current frame
+         * @brief priority of a sequence for the regression under overload: identified sequences first, then by the number of stored points
          */
-        void findClosestPixelAndInsert(std::vector<PointState>&);
+        int searchPriority(const Track&) const;
+
+        // search window of a sequence in the extended search
+        struct SearchWindow{
+            bool fallback; // input: no regression, the window is the fallback box around the last point
+            bool computed; // false if no regression could be computed for the sequence
+            cv::Point2d left_top;
+            cv::Point2d right_bottom;
+        };
+        std::vector<SearchWindow> search_windows_; // one per sequence of the extended search, reused for every frame
+        SparseAssignment assignment_; // points to sequences of the local and of the extended search, reused for every frame
+        std::vector<GatingCandidate> box_candidates_;
+        std::vector<int> local_assigned_; // point assigned to each sequence by the local search, -1 if none
+
+        // tiled local search, reused for every frame
+        struct LocalSearchTile{
+            SparseAssignment assignment;
+            std::vector<GatingCandidate> candidates;
+            std::vector<int> points; // frame point of each column of the assignment
+        };
+        static constexpr int max_local_search_tiles_ = 64; // the tiles are enlarged for widely spread sequences - more tiles than threads only balance the load
+        std::vector<LocalSearchTile> tiles_;
+        std::vector<int> track_tile_; // tile of each sequence, -1 for the sequences in the halo
+        std::vector<int> tile_track_start_; // first entry of each tile in tile_tracks_
+        std::vector<int> tile_tracks_; // sequences ordered by tile
+        std::vector<int> tile_fill_;
+        std::vector<int> point_column_; // column of each frame point in the assignment of its tile
+
+        static constexpr size_t trace_capacity_ = 1 << 14; // newest trace events kept in memory
+        Instrumentation instrumentation_{trace_capacity_}; // stage latencies and counters, trace events are only recorded with the debug flag - the ring is allocated by setDebugFlags()
+
+        // asynchronous mode: the frames are copied into the queue and processed by the tracker thread
+        std::unique_ptr<FrameQueue> frame_queue_;
+        std::thread tracker_thread_;
+        QueuedFrame tracker_frame_; // frame the tracker thread is working on
+        LatencyHistogram queue_wait_;
+        LatencyHistogram frame_latency_;
+        std::atomic<uint64_t> async_processed_{0};
+        std::atomic<uint64_t> coalesced_{0};
+
+        /**
+         * @brief loop of the tracker thread, processes the queued frames until the queue is stopped
+         */
+        void trackerLoop();
+
+        /**
+         * @brief check if distance between the last point in the sequences and point in current frame is within the "max_px_shift" allowed distance. If yes, point in current frame is inserted otherwise the sequence is passed to expandedSearch()
+         * The candidate points are looked up in the spatial index of the frame, only the grid cells overlapped by the search window are visited.
+         * All candidates of all sequences are assigned in one batch: as many sequences as possible get a point, with the minimal sum of squared distances to their last points. With "local_search_tile_size" the frame is split by tiledLocalSearch()
+         * @param points points in the current frame
+         */
+        void findClosestPixelAndInsert(const PointsView&);
         
         /**
-         * @brief receives: sequences with no inserted points + points in current frame that were not inserted.
-         * Calls selectStatisticsValues() and checks if point in current frame is in bounding box of the prediction. If it is inside bounding box the point is insert to the query sequence 
+         * @brief parallel local search for dense frames: the sequences are partitioned into square tiles of "local_search_tile_size" by their last point.
+         * The sequences whose search window lies inside one tile are assigned per tile, the tiles concurrently on the worker pool. The windows in the halo of
+         * max_px_shift at the tile borders may reach into other tiles - these sequences are assigned afterwards in one batch to the points the tiles left.
+         * The tiles only depend on the frame, so the result is the same for any number of threads. Fills local_assigned_ and takes the assigned points
+         */
+        void tiledLocalSearch();
+
+        /**
+         * @brief receives: sequences with no inserted points + points in current frame. Points already taken in the spatial index of the frame are skipped.
+         * First the search windows of all sequences are predicted - in parallel on the worker pool if there are at least "parallel_search_threshold" sequences.
+         * Then the remaining points inside the predicted bounding boxes are assigned in one batch like in findClosestPixelAndInsert().
+         * The predictions only depend on the own sequence and the assignment not on the order of the sequences, so the result is the same for any number of threads
          * 
-         * @param no_nn_current_frame vector of points in the current frame, with no nearest neighbour in the current sequences
-         * @param sequences_no_insert vector of sequences with no new inserted points in the current frame
+         * @param sequences_no_insert vector of sequences with no new inserted points in the current frame, only the sequences without insert are kept
          */
-        void extendedSearch(std::vector<PointState>& , std::vector<seqPointer>&);
+        void extendedSearch(std::vector<TrackHandle>&);
 
         /**
-         * @brief push the current point to the end of the sequence + delete first element if seq exceeds the wanted sequence length for the polynomial regression
+         * @brief prediction of the Predictor of "predictor_mode", the prediction interval is bounded to [max_px_shift, 2 * max_px_shift]. Only accesses the passed track.
+         * If the window is marked as fallback the window is the largest prediction window (2 * max_px_shift) around the last point, without a regression
+         * @param track
+         * @param frame_stamp_ns time stamp of the current frame
+         * @param window output
+         */
+        void predictSearchWindow(Track&, const int64_t&, SearchWindow&);
+
+        /**
+         * @brief add the points inside the box as candidates of the last row of the assignment, the cost is the squared distance to the anchor
+         */
+        void addAssignmentCandidates(const cv::Point2d&, const cv::Point2d&, const cv::Point2d&);
+
+        /**
+         * @brief optimal assignment up to "assignment_exact_limit" candidates and within the frame budget, greedy by distance otherwise
+         */
+        void solveAssignment();
+
+        /**
+         * @return true if an assignment with the number of candidates is solved optimally, counts the greedy ones. Thread safe
+         */
+        bool exactAssignment(const size_t&);
+
+        /**
+         * @brief push the current point to the end of the sequence through the predictor, the track drops its oldest element if it exceeds the wanted sequence length for the polynomial regression
          * @param sequence sequence where query point will be inserted
          * @param signal query point
          */
-        void insertPointToSequence(std::vector<PointState> &, const PointState);
+        void insertPointToSequence(Track &, const TrackSample&);
 
         /**
-         * @brief insert "off"-point at the end of the sequence with current time with same position as last point in the sequence
+         * @brief "on"-point of the current frame as it is stored in a track
+         * @param index index of the point in the frame
+         */
+        TrackSample frameSample(const int&) const;
+
+        /**
+         * @brief insert "off"-point at the end of the sequence with current time of the clock with same position as last point in the sequence
          * @param seq seq where the "off" will be inserted 
          */
-        void insertVPforSequencesWithNoInsert(seqPointer &);
+        void insertVPforSequencesWithNoInsert(Track &);
 
         /**
-         * @brief computes the expected prediction for a new appearing point by doing a polynomial regression and computing the prediction interval
-         * @param values x or y coordinate
-         * @param time insert time of the x or y coordinate
-         * @param insert_time the current time stamp for which the next pixel should be inserted
-         * @return PredictionStatistics 
+         * @brief predictor of "predictor_mode" for the current tables
          */
-        PredictionStatistics selectStatisticsValues(const std::vector<double>&, const std::vector<double>&, const double&);
+        std::unique_ptr<Predictor> createPredictor() const;
 
         /**
-         * @brief checks all sequences if one violates the current sequence settings or if the time since a new inserted bit is too long ago
+         * @brief checks all sequences if one violates the current sequence settings or if the time since a new inserted bit is too long ago.
+         * Uses the consecutive "off"-point counter of each sequence - constant time per sequence
          */
         void cleanPotentialBuffer();
 
+        /**
+         * @brief matches all sequences and publishes the snapshot of the current frame for getResults()
+         */
+        void publishResults();
+
+        /**
+         * @brief record a change of the track for pollEvents(), does nothing if the events are disabled
+         * @param type
+         * @param handle
+         * @param track the newest point and the cached id of the track are reported
+         * @param previous_id only used for TrackEventType::identity_changed
+         */
+        void recordEvent(const TrackEventType&, const TrackHandle&, const Track&, const int& = -1);
+
     public:
 
-        AMI(const loadedParamsForAMI&);
+        /**
+         * @param params
+         * @param worker_pool pool for the predictions of the extended search, e.g. shared by the streams of a TrackerHost. If nullptr the tracker starts its own pool with "worker_threads" threads
+         */
+        AMI(const loadedParamsForAMI&, std::shared_ptr<WorkerPool> = nullptr);
         ~AMI();
         
+        /**
+         * @brief with the debug flag the predictions, insertions and matches are written as binary events to the trace ring, see dumpTrace()
+         */
         void setDebugFlags(bool);
+        /**
+         * @brief set the framerate of the camera, with "frame_budget_fraction" it also sets the time budget per frame for the load shedding
+         */
         void updateFramerate(double);
 
+        /**
+         * @brief replace the source of the current time, the default FrameClock takes the time from the frame stamps
+         * @param clock
+         */
+        void setClock(std::unique_ptr<Clock>);
+
         /**
          * @brief Set the Sequences for the SignalMatcher
          * @param i_sequences vector of the sequences
@@ -105,16 +297,119 @@ namespace uvdar
         bool setSequences(std::vector<std::vector<bool>>);
 
         /**
-         * @brief called by blink processor - inserts point to custom data structure + calls findClosestPixelAndInsert() and cleanPotentialBuffer()
-         * @param points in mrs_msgs format
+         * @brief use tables that were already built for the sequences, e.g. shared by the streams of a TrackerHost
+         * @param tables built with the same "allowed_BER_per_seq", "stored_seq_len_factor", "decay_factor" and "conf_probab_percent" as the params of the tracker
+         * @return false if there are no sequences or the max number of zeros is higher than the length of the sequence
+         */
+        bool setSequences(std::shared_ptr<const SequenceTables>);
+
+        /**
+         * @brief processes one frame: calls findClosestPixelAndInsert() and cleanPotentialBuffer(), publishes the results of the frame.
+         * The points are read in place from the view, coordinates keep their sub-pixel precision. Always synchronous - must not be mixed with submitFrame() in asynchronous mode
+         * @param points view of the (x, y) image points of the frame, only accessed during the call
+         * @param stamp_ns time stamp of the frame in nanoseconds
+         * @param publish if false the results of the frame are not published - a newer frame follows immediately
+         */
+        void processFrame(const PointsView&, const int64_t&, const bool& = true);
+
+        /**
+         * @brief in asynchronous mode ("async_queue_length" > 0) the frame is copied into the queue of the tracker thread - constant time unless the queue is full and the policy is BackpressurePolicy::block.
+         * Otherwise the frame is processed by processFrame(). Must only be called from one thread
+         * @param points view of the (x, y) image points of the frame, only accessed during the call
+         * @param stamp_ns time stamp of the frame in nanoseconds
+         */
+        void submitFrame(const PointsView&, const int64_t&);
+
+        /**
+         * @brief wait until all submitted frames are processed
+         */
+        void flush();
+
+        /**
+         * @brief append every frame passed to submitFrame() to a frame log, e.g. to replay a flight for parameter tuning.
+         * The frames are written by the calling thread of submitFrame() through a buffered stream. Can be called while frames are submitted
+         * @param path the log is replaced, an empty path stops the recording
+         * @return false if the log cannot be created
+         */
+        bool recordFrames(const std::string&);
+
+        /**
+         * @brief append the frame to the log of recordFrames(), nothing if no log is recorded. Called by submitFrame(), the TrackerHost calls it for the frames of its streams
+         */
+        void recordFrame(const PointsView&, const int64_t&);
+
+        /**
+         * @brief queue depth, dropped frames and latency of the asynchronous mode
          */
-        void processBuffer(const uvdar_core::ImagePointsWithFloatStampedConstPtr);
+        IngestionStatistics getIngestionStatistics() const;
 
         /**
-        * @brief compares the original sequences with the extracted ones.
-        * @return returns the sequences with seq id to the bp_tim.cpp 
+        * @brief latest published results: the original sequences compared with the extracted ones. Wait-free - never blocks and is never blocked by processFrame().
+        * Must only be called from one consumer thread, the returned snapshot stays valid until the next call
+        * @return returns the newest point of each sequence with seq id to the bp_tim.cpp 
         */
-        std::vector<std::pair<seqPointer, int>> getResults();
+        const ResultSnapshot& getResults();
+
+        /**
+         * @brief changes of the tracks since the last call: created, identity changed, position updated and lost tracks, in the order they happened.
+         * Requires "event_queue_length" > 0. Must only be called from one consumer thread, never blocks the processing for longer than swapping two vectors
+         * @param events output, replaced by the pending events - the storage of the passed vector is reused
+         * @return false if events were dropped because more than "event_queue_length" events were pending, the consumer has to resynchronize with getResults()
+         */
+        bool pollEvents(std::vector<TrackEvent>&);
+
+        /**
+         * @brief copy all stored points of a sequence
+         * @param handle handle of the sequence from getResults()
+         * @param points output, oldest point first
+         * @return false if the sequence does not exist anymore
+         */
+        bool getSequence(const TrackHandle&, std::vector<PointState>&);
+
+        /**
+         * @brief occupancy of the sequence storage
+         */
+        TrackPoolStatistics getPoolStatistics();
+
+        /**
+         * @brief latency of the processing stages, event counters, number of tracks and memory footprint since the construction or the last resetStatistics()
+         */
+        TrackerStatistics getStatistics();
+        void resetStatistics();
+
+        /**
+         * @brief write the trace events kept in memory to a binary file (TraceFileHeader followed by TraceEvent records), can be called while frames are processed
+         * @param path
+         * @return false if the file cannot be written
+         */
+        bool dumpTrace(const std::string&) const;
+
+        /**
+         * @brief binary snapshot of the tracker: the parameters, the original sequences and all tracks with their points, led states, cached ids, predictions and predictor states.
+         * Can be called periodically while frames are processed: it waits for the end of the current frame, only the copy into the buffer blocks the next frame
+         * @param buffer output, replaced - its capacity is reused
+         */
+        void saveSnapshot(std::vector<uint8_t>&);
+
+        /**
+         * @brief saveSnapshot() to a file, the file is replaced atomically (written to "<path>.tmp" and renamed)
+         * @return false if the file cannot be written
+         */
+        bool writeSnapshot(const std::string&);
+
+        /**
+         * @brief replace all tracks by the tracks of a snapshot, the next frame continues as if the tracker had never stopped. Called while frames are processed, it waits for the end of the current frame.
+         * If no sequences were set the sequences of the snapshot are used. Reported to pollEvents() as lost and created tracks
+         * @param data snapshot of saveSnapshot()
+         * @param size bytes
+         * @return false if the snapshot is damaged, was written by a different build or with different sequences or regression/predictor parameters - the tracks are then kept
+         */
+        bool restoreSnapshot(const uint8_t*, const size_t&);
+
+        /**
+         * @brief restoreSnapshot() from a file
+         */
+        bool readSnapshot(const std::string&);
         
     };    
 } // namespace uvdar
\ No newline at end of file
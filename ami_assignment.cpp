@@ -0,0 +1,226 @@
+#include "ami_assignment.h"
+
+namespace uvdar
+{
+
+    void SparseAssignment::reset(const int &cols)
+    {
+        cols_ = cols;
+        row_keys_.clear();
+        row_start_.clear();
+        candidate_rows_.clear();
+        candidate_cols_.clear();
+        candidate_costs_.clear();
+    }
+
+    int SparseAssignment::addRow(const uint64_t &key)
+    {
+        row_keys_.push_back(key);
+        row_start_.push_back((int)candidate_cols_.size());
+        return (int)row_keys_.size() - 1;
+    }
+
+    void SparseAssignment::addCandidate(const int &col, const double &cost)
+    {
+        candidate_rows_.push_back((int)row_keys_.size() - 1);
+        candidate_cols_.push_back(col);
+        candidate_costs_.push_back(cost);
+    }
+
+    void SparseAssignment::solve(const bool &exact)
+    {
+        row_match_.assign(row_keys_.size(), -1);
+        col_match_.assign(cols_, -1);
+        if (candidate_cols_.empty())
+            return;
+        if (exact)
+        {
+            solveExact();
+        }
+        else
+        {
+            solveGreedy();
+        }
+    }
+
+    void SparseAssignment::solveExact()
+    {
+        const int rows = (int)row_keys_.size();
+        // every row gets a private column "unassigned" that costs more than any assignment of the other rows can save -
+        // the solution assigns as many rows as possible, among those it has the minimal sum of costs
+        unassigned_cost_ = 1.0;
+        for (int row = 0; row < rows; ++row)
+        {
+            double max_cost = 0.0;
+            for (int k = row_start_[row]; k < rowEnd(row); ++k)
+                max_cost = std::max(max_cost, candidate_costs_[k]);
+            unassigned_cost_ += max_cost;
+        }
+        col_match_.assign(cols_ + rows, -1);
+        row_potential_.assign(rows, 0.0);
+        col_potential_.assign(cols_ + rows, 0.0);
+        col_distance_.assign(cols_ + rows, std::numeric_limits<double>::infinity());
+        col_predecessor_.assign(cols_ + rows, -1);
+        col_finalized_.assign(cols_ + rows, 0);
+
+        order_.resize(rows);
+        std::iota(order_.begin(), order_.end(), 0);
+        if (!std::is_sorted(row_keys_.begin(), row_keys_.end()))
+            std::sort(order_.begin(), order_.end(), [&](int a, int b)
+                      { return row_keys_[a] < row_keys_[b]; });
+        // the "unassigned" columns are numbered by the keys, ties between them do not depend on the order of the rows either
+        row_rank_.resize(rows);
+        for (int rank = 0; rank < rows; ++rank)
+            row_rank_[order_[rank]] = rank;
+
+        for (int row : order_)
+        {
+            if (row_start_[row] == rowEnd(row))
+                continue;
+            // most tracks do not compete for a point: the closest candidate is still free
+            int best = -1;
+            for (int k = row_start_[row]; k < rowEnd(row); ++k)
+            {
+                if (best == -1 || candidate_costs_[k] < candidate_costs_[best] || (candidate_costs_[k] == candidate_costs_[best] && candidate_cols_[k] < candidate_cols_[best]))
+                    best = k;
+            }
+            const int col = candidate_cols_[best];
+            if (col_match_[col] == -1)
+            {
+                // the shortest augmenting path of length 1, the potentials are updated like in augment()
+                row_potential_[row] = -candidate_costs_[best];
+                row_match_[row] = col;
+                col_match_[col] = row;
+                continue;
+            }
+            augment(row);
+        }
+        for (int row = 0; row < rows; ++row)
+        {
+            if (row_match_[row] >= cols_)
+                row_match_[row] = -1;
+        }
+    }
+
+    void SparseAssignment::augment(const int &source)
+    {
+        touched_cols_.clear();
+        finalized_cols_.clear();
+        heap_.clear();
+        const auto later = std::greater<std::pair<double, int>>();
+
+        int row = source;
+        double row_distance = 0.0;
+        int sink = -1;
+        double sink_distance = 0.0;
+        while (true)
+        {
+            for (int k = row_start_[row]; k <= rowEnd(row); ++k)
+            {
+                const bool unassigned = k == rowEnd(row);
+                const int col = unassigned ? cols_ + row_rank_[row] : candidate_cols_[k];
+                if (col_finalized_[col])
+                    continue;
+                const double reduced = std::max((unassigned ? unassigned_cost_ : candidate_costs_[k]) + row_potential_[row] - col_potential_[col], 0.0);
+                const double distance = row_distance + reduced;
+                if (distance < col_distance_[col])
+                {
+                    if (col_distance_[col] == std::numeric_limits<double>::infinity())
+                        touched_cols_.push_back(col);
+                    col_distance_[col] = distance;
+                    col_predecessor_[col] = row;
+                    heap_.emplace_back(distance, col);
+                    std::push_heap(heap_.begin(), heap_.end(), later);
+                }
+            }
+
+            // the closest column not yet finalized, on equal distance the lower column
+            int col = -1;
+            while (!heap_.empty())
+            {
+                std::pop_heap(heap_.begin(), heap_.end(), later);
+                const std::pair<double, int> entry = heap_.back();
+                heap_.pop_back();
+                if (!col_finalized_[entry.second] && entry.first == col_distance_[entry.second])
+                {
+                    col = entry.second;
+                    break;
+                }
+            }
+            if (col == -1)
+                break; // not reached, the column "unassigned" of the source is always free
+            col_finalized_[col] = 1;
+            finalized_cols_.push_back(col);
+            if (col_match_[col] == -1)
+            {
+                sink = col;
+                sink_distance = col_distance_[col];
+                break;
+            }
+            // the assigned edge has a reduced cost of 0, its row is reached at the same distance
+            row = col_match_[col];
+            row_distance = col_distance_[col];
+        }
+
+        if (sink != -1)
+        {
+            // keeps the reduced costs non-negative and zero on the assigned edges, the unvisited part keeps its potentials
+            row_potential_[source] -= sink_distance;
+            for (int col : finalized_cols_)
+            {
+                col_potential_[col] += col_distance_[col] - sink_distance;
+                if (col != sink)
+                    row_potential_[col_match_[col]] += col_distance_[col] - sink_distance;
+            }
+            int col = sink;
+            while (true)
+            {
+                const int predecessor = col_predecessor_[col];
+                const int previous = row_match_[predecessor];
+                row_match_[predecessor] = col;
+                col_match_[col] = predecessor;
+                if (predecessor == source)
+                    break;
+                col = previous;
+            }
+        }
+
+        for (int col : touched_cols_)
+        {
+            col_distance_[col] = std::numeric_limits<double>::infinity();
+            col_finalized_[col] = 0;
+        }
+    }
+
+    size_t SparseAssignment::memoryBytes() const
+    {
+        return row_keys_.capacity() * sizeof(uint64_t) +
+               (row_start_.capacity() + candidate_rows_.capacity() + candidate_cols_.capacity() + row_match_.capacity() + col_match_.capacity() + col_predecessor_.capacity() +
+                touched_cols_.capacity() + finalized_cols_.capacity() + order_.capacity() + row_rank_.capacity()) * sizeof(int) +
+               (candidate_costs_.capacity() + row_potential_.capacity() + col_potential_.capacity() + col_distance_.capacity()) * sizeof(double) +
+               col_finalized_.capacity() + heap_.capacity() * sizeof(std::pair<double, int>);
+    }
+
+    void SparseAssignment::solveGreedy()
+    {
+        order_.resize(candidate_cols_.size());
+        std::iota(order_.begin(), order_.end(), 0);
+        std::sort(order_.begin(), order_.end(), [&](int a, int b)
+                  {
+                      if (candidate_costs_[a] != candidate_costs_[b])
+                          return candidate_costs_[a] < candidate_costs_[b];
+                      if (row_keys_[candidate_rows_[a]] != row_keys_[candidate_rows_[b]])
+                          return row_keys_[candidate_rows_[a]] < row_keys_[candidate_rows_[b]];
+                      return candidate_cols_[a] < candidate_cols_[b]; });
+        for (int k : order_)
+        {
+            const int row = candidate_rows_[k], col = candidate_cols_[k];
+            if (row_match_[row] == -1 && col_match_[col] == -1)
+            {
+                row_match_[row] = col;
+                col_match_[col] = row;
+            }
+        }
+    }
+
+} // uvdar
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <bits/stdc++.h>
+
+namespace uvdar{
+
+    /**
+     * @brief assignment of the points of a frame to the tracks over a sparse cost structure: every track (row) only has the gated points (columns) of its search window as candidates.
+     * The exact solver assigns as many tracks as possible with the minimal sum of costs by successive shortest augmenting paths (sparse Hungarian / Jonker-Volgenant with Dijkstra),
+     * an augmentation only visits the tracks that compete for the same points. The greedy solver assigns the candidates in the order of their costs, O(E log E) for very large frames.
+     * Ties are resolved by the key of the row and the column index, so the result does not depend on the order the rows were added.
+     * The storage is reused, no allocation once it reached the size of a frame
+     */
+    class SparseAssignment{
+
+        private:
+            std::vector<uint64_t> row_keys_;
+            std::vector<int> row_start_; // first candidate of each row, the candidates of a row are contiguous
+            std::vector<int> candidate_rows_;
+            std::vector<int> candidate_cols_;
+            std::vector<double> candidate_costs_;
+            int cols_ = 0;
+
+            std::vector<int> row_match_; // assigned column of each row, -1 if none
+            std::vector<int> col_match_; // assigned row of each column and of the "unassigned" columns of the exact solver, -1 if none
+            std::vector<double> row_potential_; // dual variables, the reduced cost cost + row_potential - col_potential is never negative
+            std::vector<double> col_potential_;
+            double unassigned_cost_ = 0.0;
+
+            // state of one Dijkstra search
+            std::vector<double> col_distance_;
+            std::vector<int> col_predecessor_;
+            std::vector<uint8_t> col_finalized_;
+            std::vector<int> touched_cols_;
+            std::vector<int> finalized_cols_;
+            std::vector<std::pair<double, int>> heap_;
+
+            std::vector<int> order_; // rows by key (exact) or candidates by cost (greedy)
+            std::vector<int> row_rank_; // position of each row in the key order
+
+            int rowEnd(const int& row) const { return row + 1 < (int)row_start_.size() ? row_start_[row + 1] : (int)candidate_cols_.size(); }
+
+            /**
+             * @brief shortest augmenting path from the free row, the potentials of the visited rows and columns are updated.
+             * The columns cols_ + rank of the row stand for "row unassigned", an augmentation reassigns the other rows of the path
+             */
+            void augment(const int&);
+
+            void solveExact();
+            void solveGreedy();
+
+        public:
+            /**
+             * @brief start a new problem
+             * @param cols number of points of the frame
+             */
+            void reset(const int&);
+
+            /**
+             * @brief start the candidates of the next row
+             * @param key unique key of the row for the resolution of ties, e.g. the track id
+             * @return index of the row
+             */
+            int addRow(const uint64_t&);
+
+            /**
+             * @brief candidate of the last added row
+             * @param col
+             * @param cost non-negative
+             */
+            void addCandidate(const int&, const double&);
+
+            /**
+             * @param exact false uses the greedy solver
+             */
+            void solve(const bool&);
+
+            /**
+             * @return assigned column of the row, -1 if the row got no point
+             */
+            int assignedColumn(const int& row) const { return row_match_[row]; }
+
+            int rows() const { return (int)row_keys_.size(); }
+            size_t candidates() const { return candidate_cols_.size(); }
+
+            /**
+             * @brief heap storage in bytes
+             */
+            size_t memoryBytes() const;
+    };
+
+} // uvdar
@@ -0,0 +1,659 @@
+/**
+ * Throughput, latency and accuracy benchmark of the AMI on synthetic scenes.
+ * Every configuration feeds the frames of a SceneGenerator to AMI::processFrame() and reports, for each predictor side by side,
+ * frames per second, p50/p99 latency per frame, heap allocations per frame and the identification accuracy against the ground truth.
+ *
+ * usage: ami_benchmark [--markers 1,10,100,1000] [--frames 600] [--warmup 100] [--motion linear|agile|jitter]
+ *                      [--false-positives mean_per_frame] [--occlusion probability] [--threads n [--tile-size px]] [--predictor poly,rls,cv,ca]
+ *                      [--sequences 1110100,1011000,...] [--seed n] [--stages 1]
+ *                      [--budget fraction_of_frame_period] [--cameras 1,2,4,8 [--tracker-threads n]]
+ *                      [--max-px-shift n] [--poly-order n] [--decay-factor d] [--conf-probab-percent p]
+ *                      [--record frame_log | --replay frame_log] [--check-tiles 1]
+ *
+ * With --cameras the scenes of several cameras are fed to one TrackerHost and the CPU time per camera and frame is reported instead.
+ * --record writes the frames of the scene with the first number of markers to a frame log and exits. --replay feeds a frame log,
+ * e.g. recorded by AMI::recordFrames() during a flight, to the tracker instead of a scene - without ground truth only the throughput and
+ * the identified tracks are reported. Parameter sweeps run one process per parameter set, the processes share the mapped log.
+ * --check-tiles compares the tracks of the serial local search with those of the tiled local search with a single tile covering the scene, frame by frame - they have to be the same.
+ */
+
+#include "ami.h"
+#include "ami_scene_generator.h"
+#include "ami_tracker_host.h"
+
+using namespace uvdar;
+
+namespace
+{
+    std::atomic<long> allocations{0};
+}
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // the replaced operator new allocates with malloc
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+
+namespace
+{
+
+    struct BenchmarkOptions
+    {
+        std::vector<int> markers = {1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000};
+        int frames = 600;
+        int warmup = 100; // frames before the measurement, the tracks have to fill up first
+        int threads = 0;
+        int tile_size = 0; // local_search_tile_size of the tracker
+        bool stages = false; // print the latencies of the processing stages
+        bool check_tiles = false; // compare the serial local search with a single tile instead of benchmarking
+        double budget = 0.0; // frame_budget_fraction of the tracker, 0 disables the load shedding
+        std::vector<PredictorMode> predictor_modes = {PredictorMode::poly_regression, PredictorMode::recursive_least_squares, PredictorMode::constant_velocity, PredictorMode::constant_acceleration};
+        std::vector<int> cameras; // streams of a TrackerHost, empty benchmarks a single AMI
+        int tracker_threads = 1;
+        int max_px_shift = 3;
+        int poly_order = 2;
+        double decay_factor = 0.1;
+        double conf_probab_percent = 75;
+        std::string record_path;
+        std::string replay_path;
+        SceneParams scene;
+    };
+
+    struct BenchmarkResult
+    {
+        double fps = 0;
+        double p50_us = 0;
+        double p99_us = 0;
+        double allocations_per_frame = 0;
+        double id_precision = 0; // identified tracks at a marker with the same sequence
+        double id_recall = 0; // visible markers with a correctly identified track
+        int tracks = 0;
+        TrackerStatistics statistics;
+    };
+
+    std::vector<std::vector<bool>> parseSequences(const std::string &list)
+    {
+        std::vector<std::vector<bool>> sequences;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            std::vector<bool> sequence;
+            for (char c : item)
+                sequence.push_back(c == '1');
+            if (!sequence.empty())
+                sequences.push_back(sequence);
+        }
+        return sequences;
+    }
+
+    bool parsePredictorModes(const std::string &list, std::vector<PredictorMode> &modes)
+    {
+        modes.clear();
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+        {
+            bool known = false;
+            for (PredictorMode mode : {PredictorMode::poly_regression, PredictorMode::recursive_least_squares, PredictorMode::constant_velocity, PredictorMode::constant_acceleration})
+            {
+                if (item == predictorModeName(mode))
+                {
+                    modes.push_back(mode);
+                    known = true;
+                }
+            }
+            if (!known)
+                return false;
+        }
+        return !modes.empty();
+    }
+
+    std::vector<int> parseIntList(const std::string &list)
+    {
+        std::vector<int> values;
+        std::stringstream stream(list);
+        std::string item;
+        while (std::getline(stream, item, ','))
+            values.push_back(std::stoi(item));
+        return values;
+    }
+
+    bool parseOptions(int argc, char **argv, BenchmarkOptions &options)
+    {
+        options.scene.sequences = parseSequences("1110100,1011000,1101000,1001100,1111000,1010100,1100100,1000110");
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            if (i + 1 >= argc)
+            {
+                std::cerr << "missing value for " << arg << "\n";
+                return false;
+            }
+            const std::string value = argv[++i];
+            if (arg == "--markers")
+                options.markers = parseIntList(value);
+            else if (arg == "--frames")
+                options.frames = std::stoi(value);
+            else if (arg == "--warmup")
+                options.warmup = std::stoi(value);
+            else if (arg == "--threads")
+                options.threads = std::stoi(value);
+            else if (arg == "--tile-size")
+                options.tile_size = std::stoi(value);
+            else if (arg == "--false-positives")
+                options.scene.false_positives = std::stod(value);
+            else if (arg == "--occlusion")
+                options.scene.occlusion_probability = std::stod(value);
+            else if (arg == "--cameras")
+                options.cameras = parseIntList(value);
+            else if (arg == "--tracker-threads")
+                options.tracker_threads = std::stoi(value);
+            else if (arg == "--budget")
+                options.budget = std::stod(value);
+            else if (arg == "--stages")
+                options.stages = value != "0";
+            else if (arg == "--check-tiles")
+                options.check_tiles = value != "0";
+            else if (arg == "--max-px-shift")
+                options.max_px_shift = std::stoi(value);
+            else if (arg == "--poly-order")
+                options.poly_order = std::stoi(value);
+            else if (arg == "--decay-factor")
+                options.decay_factor = std::stod(value);
+            else if (arg == "--conf-probab-percent")
+                options.conf_probab_percent = std::stod(value);
+            else if (arg == "--record")
+                options.record_path = value;
+            else if (arg == "--replay")
+                options.replay_path = value;
+            else if (arg == "--seed")
+                options.scene.seed = (uint32_t)std::stoul(value);
+            else if (arg == "--sequences")
+                options.scene.sequences = parseSequences(value);
+            else if (arg == "--motion" && value == "linear")
+                options.scene.motion = MotionModel::linear;
+            else if (arg == "--motion" && value == "agile")
+                options.scene.motion = MotionModel::agile;
+            else if (arg == "--motion" && value == "jitter")
+                options.scene.motion = MotionModel::jitter;
+            else if (arg == "--predictor" && parsePredictorModes(value, options.predictor_modes))
+                continue;
+            else
+            {
+                std::cerr << "unknown option " << arg << " " << value << "\n";
+                return false;
+            }
+        }
+        return !options.scene.sequences.empty();
+    }
+
+    loadedParamsForAMI trackerParams(const BenchmarkOptions &options, const int &markers, const PredictorMode &predictor_mode)
+    {
+        loadedParamsForAMI params;
+        params.max_px_shift = cv::Point(options.max_px_shift, options.max_px_shift);
+        params.max_zeros_consecutive = 3;
+        params.stored_seq_len_factor = 15;
+        params.max_buffer_length = 2 * markers + 100;
+        params.poly_order = options.poly_order;
+        params.decay_factor = options.decay_factor;
+        params.conf_probab_percent = options.conf_probab_percent;
+        params.allowed_BER_per_seq = 0;
+        params.predictor_mode = predictor_mode;
+        params.worker_threads = options.threads;
+        params.local_search_tile_size = options.tile_size;
+        params.frame_budget_fraction = options.budget;
+        return params;
+    }
+
+    /**
+     * @brief counts identified tracks near a marker with the same sequence and the markers covered by such a track. The markers are bucketed into a grid of the size of the tolerance
+     */
+    class AccuracyCounter
+    {
+    private:
+        double tolerance_;
+        int cols_ = 0, rows_ = 0;
+        std::vector<int> cell_start_, sorted_;
+        std::vector<uint8_t> covered_;
+
+        int cell(const double &x, const double &y) const
+        {
+            const int col = std::clamp((int)(x / tolerance_), 0, cols_ - 1);
+            const int row = std::clamp((int)(y / tolerance_), 0, rows_ - 1);
+            return row * cols_ + col;
+        }
+
+    public:
+        long identified = 0, correct = 0, visible = 0, found = 0;
+
+        AccuracyCounter(const double &tolerance) : tolerance_(tolerance) {}
+
+        void count(const SceneGenerator &scene, const ResultSnapshot &results)
+        {
+            const auto &markers = scene.markers();
+            cols_ = (int)(scene.width() / tolerance_) + 1;
+            rows_ = (int)(scene.height() / tolerance_) + 1;
+            cell_start_.assign(cols_ * rows_ + 1, 0);
+            for (const auto &marker : markers)
+                cell_start_[cell(marker.x, marker.y) + 1]++;
+            for (int c = 0; c < cols_ * rows_; ++c)
+                cell_start_[c + 1] += cell_start_[c];
+            std::vector<int> fill(cell_start_.begin(), cell_start_.end() - 1);
+            sorted_.resize(markers.size());
+            for (int i = 0; i < (int)markers.size(); ++i)
+                sorted_[fill[cell(markers[i].x, markers[i].y)]++] = i;
+
+            covered_.assign(markers.size(), 0);
+            for (const auto &track : results.tracks)
+            {
+                if (track.id < 0)
+                    continue;
+                identified++;
+                const double x = track.last_point.point.x, y = track.last_point.point.y;
+                const int col = std::clamp((int)(x / tolerance_), 0, cols_ - 1);
+                const int row = std::clamp((int)(y / tolerance_), 0, rows_ - 1);
+                bool match = false;
+                for (int r = std::max(row - 1, 0); r <= std::min(row + 1, rows_ - 1); ++r)
+                {
+                    for (int c = std::max(col - 1, 0); c <= std::min(col + 1, cols_ - 1); ++c)
+                    {
+                        for (int k = cell_start_[r * cols_ + c]; k < cell_start_[r * cols_ + c + 1]; ++k)
+                        {
+                            const SceneMarker &marker = markers[sorted_[k]];
+                            if (marker.sequence_id == track.id && std::abs(marker.x - x) <= tolerance_ && std::abs(marker.y - y) <= tolerance_)
+                            {
+                                match = true;
+                                covered_[sorted_[k]] = 1;
+                            }
+                        }
+                    }
+                }
+                correct += match;
+            }
+            for (int i = 0; i < (int)markers.size(); ++i)
+            {
+                if (markers[i].occluded_frames > 0)
+                    continue;
+                visible++;
+                found += covered_[i];
+            }
+        }
+    };
+
+    BenchmarkResult runBenchmark(const BenchmarkOptions &options, const int &markers, const PredictorMode &predictor_mode)
+    {
+        SceneParams scene_params = options.scene;
+        scene_params.markers = markers;
+        SceneGenerator scene(scene_params);
+
+        const loadedParamsForAMI params = trackerParams(options, markers, predictor_mode);
+        AMI ami(params);
+        ami.setSequences(scene_params.sequences);
+        ami.updateFramerate(scene_params.framerate);
+
+        // a track may lag behind its marker by the "off"-points at its end
+        const double tolerance = 2 * std::max(params.max_px_shift.x, params.max_px_shift.y) + scene_params.max_speed * (params.max_zeros_consecutive + 1) + 3 * scene_params.jitter_px;
+        AccuracyCounter accuracy(tolerance);
+
+        std::vector<double> latencies_us;
+        latencies_us.reserve(options.frames);
+        long measured_allocations = 0;
+        double total_s = 0;
+        BenchmarkResult result;
+        for (int frame = 0; frame < options.warmup + options.frames; ++frame)
+        {
+            const std::vector<ScenePoint> &points = scene.nextFrame();
+            const PointsView view = PointsView::fromPoints(points.data(), points.size());
+
+            const long allocations_before = allocations.load(std::memory_order_relaxed);
+            const auto start = std::chrono::steady_clock::now();
+            ami.processFrame(view, scene.frameStampNs());
+            const auto end = std::chrono::steady_clock::now();
+            const long frame_allocations = allocations.load(std::memory_order_relaxed) - allocations_before;
+
+            const ResultSnapshot &results = ami.getResults();
+            if (frame < options.warmup)
+            {
+                if (frame == options.warmup - 1)
+                    ami.resetStatistics();
+                continue;
+            }
+            const double latency_s = std::chrono::duration<double>(end - start).count();
+            total_s += latency_s;
+            latencies_us.push_back(latency_s * 1e6);
+            measured_allocations += frame_allocations;
+            accuracy.count(scene, results);
+            result.tracks = (int)results.tracks.size();
+        }
+
+        result.statistics = ami.getStatistics();
+        if (latencies_us.empty())
+            return result;
+        std::sort(latencies_us.begin(), latencies_us.end());
+        auto percentile = [&](double p)
+        { return latencies_us[std::min((size_t)(p * latencies_us.size()), latencies_us.size() - 1)]; };
+        result.fps = latencies_us.size() / total_s;
+        result.p50_us = percentile(0.5);
+        result.p99_us = percentile(0.99);
+        result.allocations_per_frame = (double)measured_allocations / latencies_us.size();
+        result.id_precision = accuracy.identified ? (double)accuracy.correct / accuracy.identified : 0.0;
+        result.id_recall = accuracy.visible ? (double)accuracy.found / accuracy.visible : 0.0;
+        return result;
+    }
+
+    double processCpuSeconds()
+    {
+        timespec time;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+        return time.tv_sec + time.tv_nsec * 1e-9;
+    }
+
+    struct HostBenchmarkResult
+    {
+        double frames_per_s = 0; // frames of all cameras
+        double cpu_us_per_frame = 0; // CPU time of the process per frame of one camera
+        HostStatistics statistics;
+    };
+
+    /**
+     * @brief every camera sees its own scene, the frames of all cameras are submitted at once and processed by the host
+     */
+    HostBenchmarkResult runHostBenchmark(const BenchmarkOptions &options, const int &markers, const int &cameras)
+    {
+        std::vector<std::unique_ptr<SceneGenerator>> scenes;
+        for (int camera = 0; camera < cameras; ++camera)
+        {
+            SceneParams scene_params = options.scene;
+            scene_params.markers = markers;
+            scene_params.seed = options.scene.seed + 7919 * camera;
+            scenes.push_back(std::make_unique<SceneGenerator>(scene_params));
+        }
+
+        loadedParamsForAMI params = trackerParams(options, markers, options.predictor_modes[0]);
+        params.async_queue_length = 4;
+        TrackerHost host(params, cameras, options.tracker_threads);
+        host.setSequences(options.scene.sequences);
+        for (int camera = 0; camera < cameras; ++camera)
+            host.updateFramerate(camera, options.scene.framerate);
+
+        double start_cpu_s = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < options.warmup + options.frames; ++frame)
+        {
+            if (frame == options.warmup)
+            {
+                host.flush();
+                host.resetStatistics();
+                start = std::chrono::steady_clock::now();
+                start_cpu_s = processCpuSeconds();
+            }
+            for (int camera = 0; camera < cameras; ++camera)
+            {
+                const std::vector<ScenePoint> &points = scenes[camera]->nextFrame();
+                host.submitFrame(camera, PointsView::fromPoints(points.data(), points.size()), scenes[camera]->frameStampNs());
+            }
+        }
+        host.flush();
+        const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        HostBenchmarkResult result;
+        result.statistics = host.getStatistics();
+        const double camera_frames = (double)options.frames * cameras;
+        result.frames_per_s = camera_frames / elapsed_s;
+        result.cpu_us_per_frame = (processCpuSeconds() - start_cpu_s) * 1e6 / camera_frames;
+        return result;
+    }
+
+    bool recordScene(const BenchmarkOptions &options)
+    {
+        SceneParams scene_params = options.scene;
+        scene_params.markers = options.markers.front();
+        SceneGenerator scene(scene_params);
+        FrameLogWriter writer;
+        if (!writer.open(options.record_path))
+            return false;
+        for (int frame = 0; frame < options.warmup + options.frames; ++frame)
+        {
+            const std::vector<ScenePoint> &points = scene.nextFrame();
+            if (!writer.append(PointsView::fromPoints(points.data(), points.size()), scene.frameStampNs()))
+                return false;
+        }
+        std::printf("# recorded %lu frames of %d markers to %s\n", (unsigned long)writer.frames(), scene_params.markers, options.record_path.c_str());
+        return writer.close();
+    }
+
+    struct ReplayResult
+    {
+        long frames = 0;
+        double fps = 0;
+        double p50_us = 0;
+        double p99_us = 0;
+        double identified_per_frame = 0;
+        int tracks = 0;
+    };
+
+    /**
+     * @brief feeds all frames of the log to one AMI. A first pass over the frame headers sizes the tracker and pages the log in
+     */
+    bool runReplay(const BenchmarkOptions &options, const PredictorMode &predictor_mode, ReplayResult &result)
+    {
+        FrameLogReader reader;
+        if (!reader.open(options.replay_path))
+            return false;
+        LoggedFrame frame;
+        size_t max_points = 0;
+        int64_t first_stamp_ns = 0, last_stamp_ns = 0;
+        long frames = 0;
+        while (reader.next(frame))
+        {
+            max_points = std::max(max_points, frame.points.size());
+            if (frames++ == 0)
+                first_stamp_ns = frame.stamp_ns;
+            last_stamp_ns = frame.stamp_ns;
+        }
+        if (reader.truncated())
+            std::fprintf(stderr, "the frame log ends with an incomplete frame\n");
+        if (frames == 0)
+            return false;
+
+        AMI ami(trackerParams(options, (int)max_points, predictor_mode));
+        ami.setSequences(options.scene.sequences);
+        ami.updateFramerate(frames > 1 && last_stamp_ns > first_stamp_ns ? (frames - 1) * 1e9 / (last_stamp_ns - first_stamp_ns) : options.scene.framerate);
+
+        std::vector<double> latencies_us;
+        latencies_us.reserve(frames);
+        long identified = 0;
+        double total_s = 0;
+        reader.rewind();
+        while (reader.next(frame))
+        {
+            const auto start = std::chrono::steady_clock::now();
+            ami.processFrame(frame.points, frame.stamp_ns);
+            const double latency_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            total_s += latency_s;
+            latencies_us.push_back(latency_s * 1e6);
+            const ResultSnapshot &results = ami.getResults();
+            for (const auto &track : results.tracks)
+                identified += track.id >= 0;
+            result.tracks = (int)results.tracks.size();
+        }
+
+        std::sort(latencies_us.begin(), latencies_us.end());
+        result.frames = frames;
+        result.fps = frames / total_s;
+        result.p50_us = latencies_us[latencies_us.size() / 2];
+        result.p99_us = latencies_us[std::min((size_t)(0.99 * latencies_us.size()), latencies_us.size() - 1)];
+        result.identified_per_frame = (double)identified / frames;
+        return true;
+    }
+
+    /**
+     * @brief feeds the same scene to a tracker with the serial local search and to one with the tiled local search and a single tile covering the scene
+     * @return number of the first frame with different tracks, -1 if all frames are the same
+     */
+    long checkSingleTile(const BenchmarkOptions &options, const int &markers, const PredictorMode &predictor_mode)
+    {
+        SceneParams scene_params = options.scene;
+        scene_params.markers = markers;
+        SceneGenerator scene(scene_params);
+
+        // without load shedding, the results must not depend on the timing
+        loadedParamsForAMI params = trackerParams(options, markers, predictor_mode);
+        params.frame_budget_fraction = 0.0;
+        params.worker_threads = 0;
+        params.local_search_tile_size = 0;
+        AMI serial(params);
+        params.worker_threads = std::max(options.threads, 1);
+        params.parallel_search_threshold = 0;
+        params.local_search_tile_size = std::numeric_limits<int>::max() / 2;
+        AMI tiled(params);
+        for (AMI *ami : {&serial, &tiled})
+        {
+            ami->setSequences(scene_params.sequences);
+            ami->updateFramerate(scene_params.framerate);
+        }
+
+        for (long frame = 0; frame < options.warmup + options.frames; ++frame)
+        {
+            const std::vector<ScenePoint> &points = scene.nextFrame();
+            const PointsView view = PointsView::fromPoints(points.data(), points.size());
+            serial.processFrame(view, scene.frameStampNs());
+            tiled.processFrame(view, scene.frameStampNs());
+            const std::vector<TrackResult> &serial_tracks = serial.getResults().tracks, &tiled_tracks = tiled.getResults().tracks;
+            if (serial_tracks.size() != tiled_tracks.size())
+                return frame;
+            for (size_t i = 0; i < serial_tracks.size(); ++i)
+            {
+                if (serial_tracks[i].track_id != tiled_tracks[i].track_id || serial_tracks[i].id != tiled_tracks[i].id ||
+                    serial_tracks[i].last_point.point != tiled_tracks[i].last_point.point)
+                    return frame;
+            }
+        }
+        return -1;
+    }
+
+    const char *motionName(const MotionModel &motion)
+    {
+        switch (motion)
+        {
+        case MotionModel::agile:
+            return "agile";
+        case MotionModel::jitter:
+            return "jitter";
+        default:
+            return "linear";
+        }
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+    if (!options.record_path.empty())
+    {
+        if (recordScene(options))
+            return 0;
+        std::cerr << "cannot write " << options.record_path << "\n";
+        return 1;
+    }
+    if (!options.replay_path.empty())
+    {
+        std::printf("# replay %s, max_px_shift %d, poly_order %d, decay_factor %.3f, conf_probab_percent %.1f\n", options.replay_path.c_str(), options.max_px_shift,
+                    options.poly_order, options.decay_factor, options.conf_probab_percent);
+        std::printf("%10s %8s %12s %10s %10s %16s %8s\n", "predictor", "frames", "fps", "p50_us", "p99_us", "identified/frame", "tracks");
+        for (PredictorMode predictor_mode : options.predictor_modes)
+        {
+            ReplayResult result;
+            if (!runReplay(options, predictor_mode, result))
+            {
+                std::cerr << "cannot read the frame log " << options.replay_path << "\n";
+                return 1;
+            }
+            std::printf("%10s %8ld %12.1f %10.1f %10.1f %16.2f %8d\n", predictorModeName(predictor_mode), result.frames, result.fps, result.p50_us, result.p99_us,
+                        result.identified_per_frame, result.tracks);
+            std::fflush(stdout);
+        }
+        return 0;
+    }
+
+    if (options.check_tiles)
+    {
+        bool same = true;
+        for (int markers : options.markers)
+        {
+            for (PredictorMode predictor_mode : options.predictor_modes)
+            {
+                const long frame = checkSingleTile(options, markers, predictor_mode);
+                if (frame == -1)
+                {
+                    std::printf("%8d %10s single tile same as serial\n", markers, predictorModeName(predictor_mode));
+                }
+                else
+                {
+                    std::printf("%8d %10s single tile differs from serial at frame %ld\n", markers, predictorModeName(predictor_mode), frame);
+                    same = false;
+                }
+                std::fflush(stdout);
+            }
+        }
+        return same ? 0 : 1;
+    }
+
+    std::printf("# motion %s, false positives %.2f/frame, occlusion %.4f, %d frames (+%d warmup), worker threads %d, tile size %d, gating %s\n",
+                motionName(options.scene.motion), options.scene.false_positives, options.scene.occlusion_probability, options.frames, options.warmup,
+                options.threads, options.tile_size, gatingInstructionSetName(gatingInstructionSet()));
+    if (!options.cameras.empty())
+    {
+        std::printf("# tracker threads %d, predictor %s\n", options.tracker_threads, predictorModeName(options.predictor_modes[0]));
+        std::printf("%8s %8s %12s %14s %10s %10s %8s\n", "markers", "cameras", "frames/s", "cpu_us/frame", "p50_us", "p99_us", "tracks");
+        for (int markers : options.markers)
+        {
+            for (int cameras : options.cameras)
+            {
+                const HostBenchmarkResult result = runHostBenchmark(options, markers, cameras);
+                std::printf("%8d %8d %12.1f %14.1f %10.1f %10.1f %8d\n", markers, cameras, result.frames_per_s, result.cpu_us_per_frame,
+                            result.statistics.latency.p50_ns * 1e-3, result.statistics.latency.p99_ns * 1e-3, result.statistics.active_tracks);
+                std::fflush(stdout);
+            }
+        }
+        return 0;
+    }
+    std::printf("%8s %10s %12s %10s %10s %14s %12s %10s %8s\n", "markers", "predictor", "fps", "p50_us", "p99_us", "allocs/frame", "id_precision", "id_recall", "tracks");
+    for (int markers : options.markers)
+    {
+        for (PredictorMode predictor_mode : options.predictor_modes)
+        {
+            const BenchmarkResult result = runBenchmark(options, markers, predictor_mode);
+            std::printf("%8d %10s %12.1f %10.1f %10.1f %14.2f %12.3f %10.3f %8d\n", markers, predictorModeName(predictor_mode), result.fps, result.p50_us, result.p99_us,
+                        result.allocations_per_frame, result.id_precision, result.id_recall, result.tracks);
+            if (options.stages)
+            {
+                const TrackerStatistics &statistics = result.statistics;
+                for (int i = 0; i < (int)Stage::count; ++i)
+                {
+                    const StageStatistics &stage = statistics.stages[i];
+                    std::printf("    %-16s mean %10.1f us   p50 %10.1f us   p99 %10.1f us\n", stageName((Stage)i),
+                                stage.calls ? stage.total_ns * 1e-3 / stage.calls : 0.0, stage.p50_ns * 1e-3, stage.p99_ns * 1e-3);
+                }
+                std::printf("    extended search hit rate %.3f, regression fits %lu, created %lu, pruned %lu, dropped points %lu, memory %zu bytes\n",
+                            statistics.extendedSearchHitRate(), (unsigned long)statistics.regression_fits, (unsigned long)statistics.created_tracks,
+                            (unsigned long)statistics.pruned_tracks, (unsigned long)statistics.dropped_points, statistics.memory_bytes);
+                std::printf("    degraded frames %lu, fallback searches %lu, deferred prunings %lu, greedy assignments %lu\n", (unsigned long)statistics.degraded_frames,
+                            (unsigned long)statistics.fallback_searches, (unsigned long)statistics.deferred_prunings, (unsigned long)statistics.greedy_assignments);
+            }
+            std::fflush(stdout);
+        }
+    }
+    return 0;
+}
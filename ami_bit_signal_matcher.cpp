@@ -0,0 +1,68 @@
+#include "ami_bit_signal_matcher.h"
+
+namespace uvdar
+{
+
+    BitSignalMatcher::BitSignalMatcher(const std::vector<std::vector<bool>> &sequences, const int &allowed_BER)
+    {
+        allowed_BER_ = allowed_BER;
+        if (!supports(sequences))
+            return;
+
+        sequence_length_ = (int)sequences[0].size();
+        mask_ = (sequence_length_ == 64) ? ~uint64_t(0) : ((uint64_t(1) << sequence_length_) - 1);
+        rotations_.reserve(sequences.size() * sequence_length_);
+        rotation_ids_.reserve(sequences.size() * sequence_length_);
+        for (int id = 0; id < (int)sequences.size(); ++id)
+        {
+            std::vector<bool> rotated(sequences[id]);
+            for (int shift = 0; shift < sequence_length_; ++shift)
+            {
+                rotations_.push_back(pack(rotated));
+                rotation_ids_.push_back(id);
+                std::rotate(rotated.begin(), rotated.begin() + 1, rotated.end());
+            }
+        }
+    }
+
+    BitSignalMatcher::~BitSignalMatcher()
+    {
+    }
+
+    bool BitSignalMatcher::supports(const std::vector<std::vector<bool>> &sequences)
+    {
+        if (sequences.empty() || sequences[0].empty() || sequences[0].size() > 64)
+            return false;
+        for (const auto &sequence : sequences)
+        {
+            if (sequence.size() != sequences[0].size())
+                return false;
+        }
+        return true;
+    }
+
+    uint64_t BitSignalMatcher::pack(const std::vector<bool> &bits)
+    {
+        uint64_t word = 0;
+        for (bool bit : bits)
+        {
+            word = (word << 1) | uint64_t(bit);
+        }
+        return word;
+    }
+
+    int BitSignalMatcher::matchSignal(const uint64_t &history, const int &available) const
+    {
+        if (sequence_length_ == 0 || available < sequence_length_)
+            return -1;
+
+        const uint64_t signal = history & mask_;
+        for (int i = 0; i < (int)rotations_.size(); ++i)
+        {
+            if (__builtin_popcountll(signal ^ rotations_[i]) <= allowed_BER_)
+                return rotation_ids_[i];
+        }
+        return -1;
+    }
+
+} // uvdar
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <bits/stdc++.h>
+
+namespace uvdar{
+
+    /**
+     * @brief matches the newest bits of a track against the original sequences by Hamming distance on packed words.
+     * All cyclic shifts of every original sequence are precomputed as 64 bit words, a match is then one XOR + popcount per shift.
+     * Supports sets of sequences with equal length of at most 64 bits
+     */
+    class BitSignalMatcher{
+
+        private:
+            int sequence_length_ = 0;
+            int allowed_BER_ = 0;
+            uint64_t mask_ = 0;
+            std::vector<uint64_t> rotations_; // sequence_length_ cyclic shifts per sequence, in order of the sequences
+            std::vector<int> rotation_ids_; // id of the sequence each rotation belongs to
+
+        public:
+            /**
+             * @brief precompute the cyclic shifts of all sequences
+             * @param sequences original sequences
+             * @param allowed_BER allowed number of bit errors per sequence
+             */
+            BitSignalMatcher(const std::vector<std::vector<bool>>&, const int&);
+            ~BitSignalMatcher();
+
+            /**
+             * @brief checks if the set of sequences can be matched as packed words
+             * @param sequences original sequences
+             * @return true if all sequences have the same length of at most 64 bits
+             */
+            static bool supports(const std::vector<std::vector<bool>>&);
+
+            /**
+             * @brief pack bits in time order into a word - the last (newest) bit becomes bit 0
+             */
+            static uint64_t pack(const std::vector<bool>&);
+
+            /**
+             * @brief match the newest sequence length bits of the history
+             * @param history bit history of the track, bit 0 is the newest state
+             * @param available number of valid bits in the history
+             * @return id of the first sequence with a cyclic shift within the allowed bit errors, -1 if there is none or if fewer bits than the sequence length are available
+             */
+            int matchSignal(const uint64_t&, const int&) const;
+
+            int sequenceLength() const { return sequence_length_; }
+    };
+
+} // uvdar
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+
+namespace uvdar{
+
+    /**
+     * @brief source of the current time of the tracker - used for the time stamps of the "off"-points. Queried once per frame
+     */
+    class Clock{
+        public:
+            virtual ~Clock() {}
+
+            /**
+             * @param frame_stamp_ns time stamp of the frame that is processed
+             * @return current time in nanoseconds
+             */
+            virtual int64_t nowNs(const int64_t& frame_stamp_ns) = 0;
+    };
+
+    /**
+     * @brief the time is the stamp of the processed frame. The results only depend on the input, independent of the processing speed - replaying recorded frames is bit-reproducible
+     */
+    class FrameClock : public Clock{
+        public:
+            int64_t nowNs(const int64_t& frame_stamp_ns) override { return frame_stamp_ns; }
+    };
+
+} // uvdar
@@ -12,76 +12,35 @@ namespace uvdar
     {
     }
 
-    std::tuple<std::vector<double>, Eigen::VectorXd> ExtendedSearch::polyReg(const std::vector<double> &coordinate, const std::vector<double> &time, const std::vector<double> &weights, const int & poly_order)
+    bool ExtendedSearch::polyRegXY(const double *time, const double *x, const double *y, const double *weights, const int &n, const int &poly_order, PolyFitXY &fit) const
     {
-        Eigen::MatrixXd design_mat(time.size(), poly_order + 1);
-        Eigen::VectorXd pixel_vect = Eigen::VectorXd::Map(&coordinate.front(), coordinate.size());
-        Eigen::VectorXd weight_vect = Eigen::VectorXd::Map(&weights.front(), weights.size());
-        Eigen::VectorXd result(poly_order + 1);
-
-
-        Eigen::MatrixXd weight_mat = (weight_vect.asDiagonal());
-        weight_mat = weight_mat.cwiseSqrt();
-
-
-        // fill the Design matrix
-        for (int i = 0; i < (int)time.size(); ++i)
-        {
-            for (int j = 0; j < poly_order + 1; ++j)
-            {
-                if (j == 0)
-                    design_mat(i, j) = 1;
-                else
-                    design_mat(i, j) = pow(time[i], j);
-            }
-        }
-
-        Eigen::MatrixXd weighed_design_mat = weight_mat * design_mat;
-        Eigen::VectorXd weighted_pixel_vect = weight_mat * pixel_vect;
-
-        // Solve for weighted linear least squares fit
-        result = weighed_design_mat.householderQr().solve(weighted_pixel_vect);
-        std::vector<double> coeff;
-        for (int i = 0; i < result.size(); ++i)
-        {
-            coeff.push_back(result[i]);
-        }
-
-        auto prediction = design_mat * result;
-
-        return {coeff, prediction};
+        return fitPolyXY(poly_order, time, x, y, weights, n, fit);
     }
 
-    std::vector<double> ExtendedSearch::calcNormalizedWeightVect(const std::vector<double> &time)
+    void ExtendedSearch::calcNormalizedWeights(const double *time, const int &n, double *weights) const
     {
-        std::vector<double> weights;
         double sum_weights = 0.0;
-        double reference_time = time.end()[-1];
-        for (int i = 0; i < (int)time.size(); ++i)
+        double reference_time = time[n - 1];
+        for (int i = 0; i < n; ++i)
         {
             double time_dist = reference_time - time[i];
             double weight = exp(-decay_factor_ * time_dist);
             sum_weights += weight;
-            weights.push_back(weight);
+            weights[i] = weight;
         }
 
-        // normalize to sum up to 1 and use the square root of the weight
-        for (auto &weight : weights)
+        // normalize to sum up to 1
+        for (int i = 0; i < n; ++i)
         {
-            weight /= sum_weights;
+            weights[i] /= sum_weights;
         }
-
-        return weights;
     }
 
-    double ExtendedSearch::calcWeightedMean(const std::vector<double> &values, const std::vector<double> &weights)
+    double ExtendedSearch::calcWeightedMean(const double *values, const double *weights, const int &n) const
     {
-        if (weights.size() != values.size()) // guarantee stand alone functionality
-            return -1;
-
         double weighted_sum = 0.0;
 
-        for (int i = 0; i < (int)values.size(); i++)
+        for (int i = 0; i < n; i++)
         {
             weighted_sum += (values[i] * weights[i]);
         }
@@ -90,61 +49,46 @@ namespace uvdar
         return w_mean;
     }
 
-    double ExtendedSearch::calcWSSR(const Eigen::VectorXd &predictions, const std::vector<double> &values, const std::vector<double> &weights)
-    {
-
-        double sum_squared_residuals = 0;
-        for (int i = 0; i < (int)values.size(); i++)
-        {
-            sum_squared_residuals += (weights[i] * pow((predictions(i) - values[i]), 2));
-        }
-        return sum_squared_residuals;
-    }
-
-    double ExtendedSearch::confidenceInterval(const PredictionStatistics &prediction_vals, const std::vector<double> &time, const std::vector<double> &values, const std::vector<double> weights, const int &wanted_percentage)
+    double ExtendedSearch::confidenceInterval(const PredictionStatistics &prediction_vals, const double &var_time, const int &n, const int &wanted_percentage) const
     {
-
-        double w_ssr = calcWSSR(prediction_vals.predicted_vals_past, values, weights);
-
-        const int n = (int)values.size();
-        const int dof = n - (int)prediction_vals.coeff.size();
+        const int dof = n - prediction_vals.coeff_count;
         // earlier caught - here to guarantee standalone functionality 
         if (prediction_vals.mean_independent == -1.0 || dof <= 0)
         {
             return -1;
         }
 
-        double unb_estimate_error_var = w_ssr / dof;
-        double var_time = 0.0;
-        for (auto t : time)
-        {
-            var_time += pow((t - prediction_vals.mean_independent), 2);
-        }
+        double unb_estimate_error_var = prediction_vals.wssr / dof;
 
         double standard_error = sqrt(unb_estimate_error_var + (1 + 1 / n + ((prediction_vals.time_pred - prediction_vals.mean_independent) / var_time)));
 
-        double percentage_scaled = double(wanted_percentage)/100.0;
-        double percentage_two_sided = ( 1 - percentage_scaled ) / 2 + percentage_scaled;
-        boost::math::students_t dist(dof);
-        double t = quantile(dist, percentage_two_sided);
+        double t = tQuantile(dof, wanted_percentage);
         double conf_interval_prediction = t * standard_error;
 
         return conf_interval_prediction;
     }
 
-    bool ExtendedSearch::isInsideBB(const cv::Point2d &query_point, const cv::Point2d &left_top, const cv::Point2d &right_bottom)
+    void ExtendedSearch::precomputeTQuantiles(const int &max_dof, const int &wanted_percentage)
     {
-        if (left_top.x <= query_point.x && query_point.x <= right_bottom.x && left_top.y <= query_point.y && query_point.y <= right_bottom.y)
+        t_quantiles_percentage_ = -1;
+        t_quantiles_.assign(std::max(max_dof, 0) + 1, 0.0);
+        for (int dof = 1; dof <= max_dof; ++dof)
         {
-            return true;
+            t_quantiles_[dof] = tQuantile(dof, wanted_percentage);
         }
-        return false;
+        t_quantiles_percentage_ = wanted_percentage;
     }
-    
-    double ExtendedSearch::euclideanDistance(const cv::Point2d &point1, const cv::Point2d &point2)
+
+    double ExtendedSearch::tQuantile(const int &dof, const int &wanted_percentage) const
     {
-        double distance = sqrt( pow( ( point1.x - point2.x ) , 2) + pow( ( point1.y -  point2.y ), 2 ) );
-        return distance;
+        if (wanted_percentage == t_quantiles_percentage_ && dof < (int)t_quantiles_.size())
+        {
+            return t_quantiles_[dof];
+        }
+        double percentage_scaled = double(wanted_percentage)/100.0;
+        double percentage_two_sided = ( 1 - percentage_scaled ) / 2 + percentage_scaled;
+        boost::math::students_t dist(dof);
+        return quantile(dist, percentage_two_sided);
     }
 
 } // uvdar
\ No newline at end of file
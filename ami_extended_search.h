@@ -1,6 +1,7 @@
-#include <ros/console.h>
+#pragma once
+
 #include <opencv2/highgui/highgui.hpp>
-#include <Eigen/Dense>
+#include "ami_poly_reg_kernel.h"
 #include <boost/math/distributions/students_t.hpp>
 #include <bits/stdc++.h>
 
@@ -9,11 +10,14 @@
 namespace uvdar{
 
     struct PredictionStatistics{
-        double time_pred = -1;
+        double time_pred = -1; // relative to time_reference
+        double time_reference = 0; // time of the newest point used for the regression, origin of all time values
+        double time_scale = 1; // the polynomial is evaluated for (time - time_reference) / time_scale
         bool poly_reg_computed = false;
         bool extended_search = false;
-        std::vector<double> coeff;
-        Eigen::VectorXd predicted_vals_past; 
+        std::array<double, max_poly_order + 1> coeff{};
+        int coeff_count = 0;
+        double wssr = 0; // weighted sum of squared residuals of the regression
         double mean_dependent;
         double mean_independent;
         double predicted_coordinate = -1;
@@ -24,65 +28,64 @@ namespace uvdar{
         
         private: 
             double decay_factor_;
+            std::vector<double> t_quantiles_; // two-sided Student-t quantile for each degree of freedom, index = dof
+            int t_quantiles_percentage_ = -1;
 
             /**
-             * @brief calcuate weighted sum of squared residuals 
-             * @param predictions predictions for each past coordinate
-             * @param values x or y coordinates
-             * @param weights weight vector
-             * @return sum_squared_residuals 
+             * @brief two-sided Student-t quantile, taken from the precomputed table if available
              */
-            double calcWSSR(const Eigen::VectorXd&, const std::vector<double>&, const std::vector<double>&);
+            double tQuantile(const int&, const int&) const;
 
         public:
             ExtendedSearch(double);
             ~ExtendedSearch();
 
             /**
-             * @brief Calculate weighted polynomial regression 
-             * @param coordinate dependent vector 
-             * @param time independent vector 
+             * @brief precompute the Student-t quantiles for all degrees of freedom up to max_dof, so that confidenceInterval() does not need to evaluate the inverse distribution
+             * @param max_dof highest degree of freedom that can occur
+             * @param wanted_percentage wanted percentage for the t-quantil
+             */
+            void precomputeTQuantiles(const int&, const int&);
+
+            /**
+             * @brief Calculate weighted polynomial regression for the x and y coordinate over the same design matrix, without heap allocations
+             * @param time independent values
+             * @param x dependent values
+             * @param y dependent values
              * @param weights weight vector
-             * @return regression coefficients + predicted values for each data value
+             * @param n number of values, at most max_poly_reg_window
+             * @param poly_order order of the polynomial, at most max_poly_order
+             * @param fit regression coefficients + weighted sum of squared residuals
+             * @return false if the regression could not be computed
              */
-            std::tuple<std::vector<double>, Eigen::VectorXd> polyReg(const std::vector<double>&, const std::vector<double>&, const std::vector<double>&, const int &);
+            bool polyRegXY(const double*, const double*, const double*, const double*, const int&, const int&, PolyFitXY&) const;
 
             /**
-             * @brief calculates normalized weight vector with exponential decay function
-             * @param time vector
-             * @return weight vector
+             * @brief calculates normalized weights with exponential decay function
+             * @param time time values, the last one is the newest
+             * @param n number of values
+             * @param weights output array of size n
              */
-            std::vector<double> calcNormalizedWeightVect(const std::vector<double>&);
+            void calcNormalizedWeights(const double*, const int&, double*) const;
 
             /**
              * @brief calculate the weighted mean
              * @param values x or y coordinates
              * @param weights weight vector
+             * @param n number of values
              * @return double 
              */
-            double calcWeightedMean(const std::vector<double>&, const std::vector<double>&);
+            double calcWeightedMean(const double*, const double*, const int&) const;
 
             /**
-             * @brief check if point lies within box 
-             * @param query_point 
-             * @param left_top 
-             * @param right_bottom
-             * @return true/false for succress 
-             */
-            bool isInsideBB(const cv::Point2d&, const cv::Point2d&, const cv::Point2d&);
-
-            double euclideanDistance(const cv::Point2d&, const cv::Point2d&);
-            /**
-             * @brief compute the confidence interval by computing the regression accuracy and multiplying with wanted t-quantil percentage
-             * 
-             * @param prediction_vals statistics values 
-             * @param time vector of independent variable
-             * @param values x or y coordinates
-             * @param weighs weight vector
+             * @brief compute the confidence interval from the already accumulated (unweighted) squared deviation of the time values from their weighted mean
+             * @param prediction_vals statistics values, incl. the weighted sum of squared residuals
+             * @param var_time sum of the squared deviations of the time values from mean_independent
+             * @param n number of values
              * @param wanted_percentage wanted percentage for the t-quantil
              * @return -1, if not possible to compute CI from poly regression 
              * @return value, if interval can be computed
              */
-            double confidenceInterval(const PredictionStatistics&, const std::vector<double>&, const std::vector<double>&, const std::vector<double>, const int&);
+            double confidenceInterval(const PredictionStatistics&, const double&, const int&, const int&) const;
     };
 } // uvdar
\ No newline at end of file
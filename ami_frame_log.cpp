@@ -0,0 +1,153 @@
+#include "ami_frame_log.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace uvdar
+{
+
+    namespace
+    {
+        constexpr uint32_t frame_log_version = 1;
+        constexpr size_t write_buffer_size = 1 << 20;
+    }
+
+    FrameLogWriter::~FrameLogWriter()
+    {
+        close();
+    }
+
+    bool FrameLogWriter::open(const std::string &path)
+    {
+        close();
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_)
+            return false;
+        std::setvbuf(file_, nullptr, _IOFBF, write_buffer_size);
+
+        FrameLogHeader header;
+        std::memcpy(header.magic, "AMIFRLOG", sizeof(header.magic));
+        header.version = frame_log_version;
+        header.coordinate_size = sizeof(float);
+        if (std::fwrite(&header, sizeof(header), 1, file_) != 1)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    bool FrameLogWriter::close()
+    {
+        if (!file_)
+            return true;
+        const bool ok = std::fclose(file_) == 0;
+        file_ = nullptr;
+        frames_ = 0;
+        return ok;
+    }
+
+    bool FrameLogWriter::append(const PointsView &points, const int64_t &stamp_ns)
+    {
+        if (!file_)
+            return false;
+
+        xy_.resize(2 * points.size());
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            xy_[2 * i] = (float)points.x(i);
+            xy_[2 * i + 1] = (float)points.y(i);
+        }
+        FrameLogRecord record;
+        record.stamp_ns = stamp_ns;
+        record.point_count = (uint32_t)points.size();
+        record.reserved = 0;
+        if (std::fwrite(&record, sizeof(record), 1, file_) != 1 || std::fwrite(xy_.data(), sizeof(float), xy_.size(), file_) != xy_.size())
+            return false;
+        frames_++;
+        return true;
+    }
+
+    bool FrameLogWriter::flush()
+    {
+        return file_ && std::fflush(file_) == 0;
+    }
+
+    FrameLogReader::~FrameLogReader()
+    {
+        close();
+    }
+
+    bool FrameLogReader::open(const std::string &path)
+    {
+        close();
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat status;
+        if (fstat(fd, &status) != 0 || (size_t)status.st_size < sizeof(FrameLogHeader))
+        {
+            ::close(fd);
+            return false;
+        }
+        void *mapping = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // the mapping keeps the file open
+        if (mapping == MAP_FAILED)
+            return false;
+        madvise(mapping, (size_t)status.st_size, MADV_SEQUENTIAL);
+        data_ = static_cast<const uint8_t *>(mapping);
+        size_ = (size_t)status.st_size;
+
+        FrameLogHeader header;
+        std::memcpy(&header, data_, sizeof(header));
+        if (std::memcmp(header.magic, "AMIFRLOG", sizeof(header.magic)) != 0 || header.version != frame_log_version || header.coordinate_size != sizeof(float))
+        {
+            close();
+            return false;
+        }
+        rewind();
+        return true;
+    }
+
+    void FrameLogReader::close()
+    {
+        if (data_)
+            munmap(const_cast<uint8_t *>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+        position_ = 0;
+        truncated_ = false;
+    }
+
+    bool FrameLogReader::next(LoggedFrame &frame)
+    {
+        if (!data_ || position_ == size_)
+            return false;
+        FrameLogRecord record;
+        if (size_ - position_ < sizeof(record))
+        {
+            truncated_ = true;
+            return false;
+        }
+        std::memcpy(&record, data_ + position_, sizeof(record));
+        const size_t points_size = (size_t)record.point_count * 2 * sizeof(float);
+        if (size_ - position_ - sizeof(record) < points_size)
+        {
+            truncated_ = true;
+            return false;
+        }
+        const float *xy = reinterpret_cast<const float *>(data_ + position_ + sizeof(record));
+        frame.stamp_ns = record.stamp_ns;
+        frame.points = PointsView::fromInterleaved(xy, record.point_count);
+        position_ += sizeof(record) + points_size;
+        return true;
+    }
+
+    void FrameLogReader::rewind()
+    {
+        position_ = sizeof(FrameLogHeader);
+        truncated_ = false;
+    }
+
+} // uvdar
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <bits/stdc++.h>
+#include "ami_points_view.h"
+
+namespace uvdar{
+
+    // start of a frame log file, followed by the frames (little endian)
+    struct FrameLogHeader{
+        char magic[8]; // "AMIFRLOG"
+        uint32_t version;
+        uint32_t coordinate_size; // bytes of one coordinate, float
+    };
+    static_assert(sizeof(FrameLogHeader) == 16, "the frame log layout must not change");
+
+    // start of a frame in the log, followed by point_count interleaved (x, y) float coordinates - every frame starts 8 byte aligned
+    struct FrameLogRecord{
+        int64_t stamp_ns;
+        uint32_t point_count;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(FrameLogRecord) == 16, "the frame log layout must not change");
+
+    // frame read from a log, the points view the mapped file
+    struct LoggedFrame{
+        int64_t stamp_ns = 0;
+        PointsView points;
+    };
+
+    /**
+     * @brief appends frames to a frame log. The coordinates are stored as float, which is exact for integer pixel coordinates.
+     * Written through a buffered stream - a log of a crashed recorder ends with an incomplete frame, which the reader ignores
+     */
+    class FrameLogWriter{
+
+        private:
+            std::FILE* file_ = nullptr;
+            std::vector<float> xy_; // converted coordinates of the current frame, the capacity is reused
+            uint64_t frames_ = 0;
+
+        public:
+            FrameLogWriter() = default;
+            FrameLogWriter(const FrameLogWriter&) = delete;
+            FrameLogWriter& operator=(const FrameLogWriter&) = delete;
+            ~FrameLogWriter();
+
+            /**
+             * @brief create the log, an existing file is replaced
+             * @return false if the file cannot be created
+             */
+            bool open(const std::string&);
+
+            /**
+             * @brief flush and close the log
+             * @return false if buffered frames could not be written
+             */
+            bool close();
+
+            /**
+             * @param points
+             * @param stamp_ns
+             * @return false if the frame could not be written, e.g. the disk is full
+             */
+            bool append(const PointsView&, const int64_t&);
+
+            bool flush();
+
+            bool isOpen() const { return file_ != nullptr; }
+            uint64_t frames() const { return frames_; }
+    };
+
+    /**
+     * @brief reads a frame log through a read-only memory mapping. The frames are not copied: the points of a LoggedFrame view the mapping and can be
+     * passed directly to AMI::processFrame() or TrackerHost::submitFrame(). Processes replaying the same log share its pages in the page cache
+     */
+    class FrameLogReader{
+
+        private:
+            const uint8_t* data_ = nullptr;
+            size_t size_ = 0;
+            size_t position_ = 0;
+            bool truncated_ = false;
+
+        public:
+            FrameLogReader() = default;
+            FrameLogReader(const FrameLogReader&) = delete;
+            FrameLogReader& operator=(const FrameLogReader&) = delete;
+            ~FrameLogReader();
+
+            /**
+             * @brief map the log
+             * @return false if the file cannot be mapped or is no frame log
+             */
+            bool open(const std::string&);
+
+            void close();
+
+            /**
+             * @brief the next frame, valid until the reader is closed
+             * @param frame output
+             * @return false at the end of the log
+             */
+            bool next(LoggedFrame&);
+
+            /**
+             * @brief continue with the first frame
+             */
+            void rewind();
+
+            /**
+             * @brief true once next() reached an incomplete frame at the end of the log
+             */
+            bool truncated() const { return truncated_; }
+
+            bool isOpen() const { return data_ != nullptr; }
+            size_t size() const { return size_; }
+    };
+
+} // uvdar
@@ -0,0 +1,154 @@
+#include "ami_frame_queue.h"
+
+namespace uvdar
+{
+
+    FrameQueue::FrameQueue(const int &capacity)
+    {
+        capacity_ = (uint64_t)std::max(capacity, 1);
+        slots_ = std::make_unique<Slot[]>(capacity_);
+        for (uint64_t i = 0; i < capacity_; ++i)
+        {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    FrameQueue::~FrameQueue()
+    {
+        stop();
+    }
+
+    bool FrameQueue::tryPush(const PointsView &points, const int64_t &stamp_ns)
+    {
+        const uint64_t position = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot &slot = slots_[position % capacity_];
+        if (slot.sequence.load(std::memory_order_acquire) != position)
+            return false; // the slot still holds a frame of the previous round
+
+        QueuedFrame &frame = slot.frame;
+        frame.xy.resize(2 * points.size());
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            frame.xy[2 * i] = points.x(i);
+            frame.xy[2 * i + 1] = points.y(i);
+        }
+        frame.stamp_ns = stamp_ns;
+        frame.enqueue_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        slot.sequence.store(position + 1, std::memory_order_release);
+        enqueue_pos_.store(position + 1, std::memory_order_seq_cst);
+        return true;
+    }
+
+    bool FrameQueue::tryPop(QueuedFrame *frame)
+    {
+        uint64_t position = dequeue_pos_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot &slot = slots_[position % capacity_];
+            const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != position + 1)
+            {
+                if (sequence < position + 1)
+                    return false; // empty
+                position = dequeue_pos_.load(std::memory_order_relaxed);
+                continue;
+            }
+            // the producer may drop the same frame at the same time
+            if (dequeue_pos_.compare_exchange_weak(position, position + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                if (frame != nullptr)
+                {
+                    std::swap(frame->xy, slot.frame.xy);
+                    frame->stamp_ns = slot.frame.stamp_ns;
+                    frame->enqueue_ns = slot.frame.enqueue_ns;
+                }
+                slot.sequence.store(position + capacity_, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    int FrameQueue::push(const PointsView &points, const int64_t &stamp_ns, const BackpressurePolicy &policy)
+    {
+        int dropped = 0;
+        while (!tryPush(points, stamp_ns))
+        {
+            if (stopped_.load(std::memory_order_relaxed))
+                return dropped;
+            if (policy != BackpressurePolicy::block)
+            {
+                // below the capacity the tracker thread is just releasing the slot of the frame it took
+                if (depth() >= (int)capacity_ && tryPop(nullptr))
+                {
+                    dropped++;
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+                continue;
+            }
+            std::unique_lock lock(mutex_);
+            producer_waiting_.store(true, std::memory_order_seq_cst);
+            not_full_.wait(lock, [this]
+                           { return depth() < (int)capacity_ || stopped_.load(std::memory_order_relaxed); });
+            producer_waiting_.store(false, std::memory_order_relaxed);
+        }
+
+        const uint64_t current_depth = (uint64_t)depth();
+        if (current_depth > max_depth_.load(std::memory_order_relaxed))
+            max_depth_.store(current_depth, std::memory_order_relaxed);
+        if (consumer_waiting_.load(std::memory_order_seq_cst))
+        {
+            std::scoped_lock lock(mutex_);
+            not_empty_.notify_one();
+        }
+        return dropped;
+    }
+
+    bool FrameQueue::waitPop(QueuedFrame &frame)
+    {
+        while (!pop(frame))
+        {
+            std::unique_lock lock(mutex_);
+            consumer_waiting_.store(true, std::memory_order_seq_cst);
+            not_empty_.wait(lock, [this]
+                            { return depth() > 0 || stopped_.load(std::memory_order_relaxed); });
+            consumer_waiting_.store(false, std::memory_order_relaxed);
+            if (depth() == 0 && stopped_.load(std::memory_order_relaxed))
+                return false;
+        }
+        return true;
+    }
+
+    bool FrameQueue::pop(QueuedFrame &frame)
+    {
+        if (!tryPop(&frame))
+            return false;
+        if (producer_waiting_.load(std::memory_order_seq_cst))
+        {
+            std::scoped_lock lock(mutex_);
+            not_full_.notify_one();
+        }
+        return true;
+    }
+
+    void FrameQueue::stop()
+    {
+        {
+            std::scoped_lock lock(mutex_);
+            stopped_.store(true);
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    int FrameQueue::depth() const
+    {
+        const uint64_t dequeued = dequeue_pos_.load(std::memory_order_seq_cst);
+        const uint64_t enqueued = enqueue_pos_.load(std::memory_order_seq_cst);
+        return enqueued > dequeued ? (int)(enqueued - dequeued) : 0;
+    }
+
+} // uvdar
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <bits/stdc++.h>
+#include "ami_points_view.h"
+#include "ami_instrumentation.h"
+
+namespace uvdar{
+
+    // what the producer does if the queue is full
+    enum class BackpressurePolicy{
+        block, // wait until the tracker thread took a frame
+        drop_oldest, // discard the oldest queued frame
+        coalesce // discard the oldest queued frame, the tracker thread processes a backlog back to back and publishes the results only once for the newest frame
+    };
+
+    struct IngestionStatistics{
+        bool asynchronous = false; // false if the frames are processed in the calling thread
+        BackpressurePolicy policy = BackpressurePolicy::block;
+        int capacity = 0;
+        int depth = 0; // currently queued frames
+        int max_depth = 0;
+        uint64_t enqueued = 0;
+        uint64_t processed = 0;
+        uint64_t dropped = 0; // frames discarded by BackpressurePolicy::drop_oldest or coalesce
+        uint64_t coalesced = 0; // processed frames whose results were not published because a newer frame was waiting
+        StageStatistics queue_wait; // time from the push until the tracker thread takes the frame
+        StageStatistics latency; // time from the push until the results of the frame are published
+    };
+
+    // copy of a frame in the queue
+    struct QueuedFrame{
+        std::vector<double> xy; // interleaved coordinates, the capacity is reused
+        int64_t stamp_ns = 0;
+        int64_t enqueue_ns = 0; // steady clock time of the push
+    };
+
+    /**
+     * @brief bounded frame queue between one producer (camera callback) and the tracker thread.
+     * The slots carry sequence numbers (Vyukov), so besides the tracker thread the producer can also dequeue - used to drop the oldest frame without a lock.
+     * The frames are copied into preallocated slots and swapped out by the consumer, no allocation once the slots reached the maximal frame size.
+     * A thread only sleeps on a condition variable if the queue is full (BackpressurePolicy::block) or empty, the other side only takes the lock if a thread is sleeping
+     */
+    class FrameQueue{
+
+        private:
+            struct Slot{
+                std::atomic<uint64_t> sequence;
+                QueuedFrame frame;
+            };
+
+            std::unique_ptr<Slot[]> slots_;
+            uint64_t capacity_;
+            alignas(64) std::atomic<uint64_t> enqueue_pos_{0}; // only written by the producer
+            alignas(64) std::atomic<uint64_t> dequeue_pos_{0};
+
+            std::mutex mutex_;
+            std::condition_variable not_empty_;
+            std::condition_variable not_full_;
+            std::atomic<bool> consumer_waiting_{false};
+            std::atomic<bool> producer_waiting_{false};
+            std::atomic<bool> stopped_{false};
+
+            std::atomic<uint64_t> dropped_{0};
+            std::atomic<uint64_t> max_depth_{0};
+
+            bool tryPush(const PointsView&, const int64_t&);
+
+            /**
+             * @brief take the oldest frame
+             * @param frame output, swapped with the slot - nullptr discards the frame
+             */
+            bool tryPop(QueuedFrame*);
+
+        public:
+            /**
+             * @param capacity maximal number of queued frames
+             */
+            FrameQueue(const int&);
+            ~FrameQueue();
+
+            /**
+             * @brief copy the frame into the queue, called by the producer only
+             * @return number of older frames dropped to make room
+             */
+            int push(const PointsView&, const int64_t&, const BackpressurePolicy&);
+
+            /**
+             * @brief take the oldest frame, wait if the queue is empty. Called by the consumer only
+             * @param frame output, its storage is swapped into the queue
+             * @return false if the queue was stopped
+             */
+            bool waitPop(QueuedFrame&);
+
+            /**
+             * @brief take the oldest frame without waiting. Called by the consumer only
+             * @param frame output, its storage is swapped into the queue
+             * @return false if the queue is empty
+             */
+            bool pop(QueuedFrame&);
+
+            /**
+             * @brief wake up and release all waiting threads, waitPop() returns false from now on
+             */
+            void stop();
+
+            int depth() const;
+            int capacity() const { return (int)capacity_; }
+            uint64_t enqueued() const { return enqueue_pos_.load(std::memory_order_relaxed); }
+            uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+            int maxDepth() const { return (int)max_depth_.load(std::memory_order_relaxed); }
+    };
+
+} // uvdar
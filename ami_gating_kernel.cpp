@@ -0,0 +1,167 @@
+#include "ami_gating_kernel.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AMI_GATING_X86
+#endif
+
+namespace uvdar
+{
+
+    namespace
+    {
+
+        using GatingKernel = void (*)(const GatingQuery &, const double *, const double *, const int &, uint8_t *, double *);
+
+        inline void gateScalarRange(const GatingQuery &q, const double *x, const double *y, int begin, const int &end, uint8_t *in_box, double *sq_distance)
+        {
+            for (; begin < end; ++begin)
+            {
+                const double px = x[begin], py = y[begin];
+                in_box[begin] = q.left <= px && px <= q.right && q.top <= py && py <= q.bottom;
+                const double dx = px - q.anchor_x, dy = py - q.anchor_y;
+                sq_distance[begin] = dx * dx + dy * dy;
+            }
+        }
+
+        void gateScalar(const GatingQuery &q, const double *x, const double *y, const int &count, uint8_t *in_box, double *sq_distance)
+        {
+            gateScalarRange(q, x, y, 0, count, in_box, sq_distance);
+        }
+
+#ifdef AMI_GATING_X86
+
+        __attribute__((target("sse2"))) void gateSSE2(const GatingQuery &q, const double *x, const double *y, const int &count, uint8_t *in_box, double *sq_distance)
+        {
+            const __m128d ax = _mm_set1_pd(q.anchor_x), ay = _mm_set1_pd(q.anchor_y);
+            const __m128d left = _mm_set1_pd(q.left), right = _mm_set1_pd(q.right);
+            const __m128d top = _mm_set1_pd(q.top), bottom = _mm_set1_pd(q.bottom);
+
+            int i = 0;
+            for (; i + 2 <= count; i += 2)
+            {
+                const __m128d px = _mm_loadu_pd(x + i), py = _mm_loadu_pd(y + i);
+                const __m128d inside = _mm_and_pd(_mm_and_pd(_mm_cmple_pd(left, px), _mm_cmple_pd(px, right)),
+                                                  _mm_and_pd(_mm_cmple_pd(top, py), _mm_cmple_pd(py, bottom)));
+                const __m128d dx = _mm_sub_pd(px, ax), dy = _mm_sub_pd(py, ay);
+                _mm_storeu_pd(sq_distance + i, _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+                const int mask = _mm_movemask_pd(inside);
+                in_box[i] = mask & 1;
+                in_box[i + 1] = (mask >> 1) & 1;
+            }
+            gateScalarRange(q, x, y, i, count, in_box, sq_distance);
+        }
+
+        __attribute__((target("avx2"))) void gateAVX2(const GatingQuery &q, const double *x, const double *y, const int &count, uint8_t *in_box, double *sq_distance)
+        {
+            const __m256d ax = _mm256_set1_pd(q.anchor_x), ay = _mm256_set1_pd(q.anchor_y);
+            const __m256d left = _mm256_set1_pd(q.left), right = _mm256_set1_pd(q.right);
+            const __m256d top = _mm256_set1_pd(q.top), bottom = _mm256_set1_pd(q.bottom);
+
+            int i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m256d px = _mm256_loadu_pd(x + i), py = _mm256_loadu_pd(y + i);
+                const __m256d inside = _mm256_and_pd(_mm256_and_pd(_mm256_cmp_pd(left, px, _CMP_LE_OQ), _mm256_cmp_pd(px, right, _CMP_LE_OQ)),
+                                                     _mm256_and_pd(_mm256_cmp_pd(top, py, _CMP_LE_OQ), _mm256_cmp_pd(py, bottom, _CMP_LE_OQ)));
+                const __m256d dx = _mm256_sub_pd(px, ax), dy = _mm256_sub_pd(py, ay);
+                // no fused multiply-add, the distances have to match the scalar kernel bit by bit
+                _mm256_storeu_pd(sq_distance + i, _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+                const int mask = _mm256_movemask_pd(inside);
+                for (int l = 0; l < 4; ++l)
+                    in_box[i + l] = (mask >> l) & 1;
+            }
+            gateScalarRange(q, x, y, i, count, in_box, sq_distance);
+        }
+
+        // avx512f implies fma - without fp-contract=off the compiler fuses the multiplications and additions, also those of the scalar tail
+        __attribute__((target("avx512f"), optimize("fp-contract=off"))) void gateAVX512(const GatingQuery &q, const double *x, const double *y, const int &count, uint8_t *in_box, double *sq_distance)
+        {
+            const __m512d ax = _mm512_set1_pd(q.anchor_x), ay = _mm512_set1_pd(q.anchor_y);
+            const __m512d left = _mm512_set1_pd(q.left), right = _mm512_set1_pd(q.right);
+            const __m512d top = _mm512_set1_pd(q.top), bottom = _mm512_set1_pd(q.bottom);
+
+            int i = 0;
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m512d px = _mm512_loadu_pd(x + i), py = _mm512_loadu_pd(y + i);
+                __mmask8 inside = _mm512_cmp_pd_mask(left, px, _CMP_LE_OQ);
+                inside = _mm512_mask_cmp_pd_mask(inside, px, right, _CMP_LE_OQ);
+                inside = _mm512_mask_cmp_pd_mask(inside, top, py, _CMP_LE_OQ);
+                inside = _mm512_mask_cmp_pd_mask(inside, py, bottom, _CMP_LE_OQ);
+                const __m512d dx = _mm512_sub_pd(px, ax), dy = _mm512_sub_pd(py, ay);
+                _mm512_storeu_pd(sq_distance + i, _mm512_add_pd(_mm512_mul_pd(dx, dx), _mm512_mul_pd(dy, dy)));
+                for (int l = 0; l < 8; ++l)
+                    in_box[i + l] = (inside >> l) & 1;
+            }
+            gateScalarRange(q, x, y, i, count, in_box, sq_distance);
+        }
+
+#endif
+
+        GatingKernel kernelFor(const GatingInstructionSet &instruction_set)
+        {
+            switch (instruction_set)
+            {
+#ifdef AMI_GATING_X86
+            case GatingInstructionSet::avx512:
+                return gateAVX512;
+            case GatingInstructionSet::avx2:
+                return gateAVX2;
+            case GatingInstructionSet::sse2:
+                return gateSSE2;
+#endif
+            default:
+                return gateScalar;
+            }
+        }
+
+        GatingInstructionSet detectInstructionSet()
+        {
+#ifdef AMI_GATING_X86
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f"))
+                return GatingInstructionSet::avx512;
+            if (__builtin_cpu_supports("avx2"))
+                return GatingInstructionSet::avx2;
+            if (__builtin_cpu_supports("sse2"))
+                return GatingInstructionSet::sse2;
+#endif
+            return GatingInstructionSet::scalar;
+        }
+
+    } // namespace
+
+    GatingInstructionSet gatingInstructionSet()
+    {
+        static const GatingInstructionSet instruction_set = detectInstructionSet();
+        return instruction_set;
+    }
+
+    const char *gatingInstructionSetName(const GatingInstructionSet &instruction_set)
+    {
+        switch (instruction_set)
+        {
+        case GatingInstructionSet::sse2:
+            return "sse2";
+        case GatingInstructionSet::avx2:
+            return "avx2";
+        case GatingInstructionSet::avx512:
+            return "avx512";
+        default:
+            return "scalar";
+        }
+    }
+
+    void gateBox(const GatingQuery &query, const double *x, const double *y, const int &count, uint8_t *in_box, double *sq_distance)
+    {
+        static const GatingKernel kernel = kernelFor(gatingInstructionSet());
+        kernel(query, x, y, count, in_box, sq_distance);
+    }
+
+    void gateBox(const GatingInstructionSet &instruction_set, const GatingQuery &query, const double *x, const double *y, const int &count, uint8_t *in_box, double *sq_distance)
+    {
+        kernelFor(instruction_set)(query, x, y, count, in_box, sq_distance);
+    }
+
+} // uvdar
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <bits/stdc++.h>
+
+namespace uvdar{
+
+    // search window of one track: anchor for the distance and the box the candidates must lie in (borders included)
+    struct GatingQuery{
+        double anchor_x;
+        double anchor_y;
+        double left;
+        double top;
+        double right;
+        double bottom;
+    };
+
+    // point inside a search window, candidate of the assignment of a track
+    struct GatingCandidate{
+        double sq_distance = std::numeric_limits<double>::max();
+        int index = -1;
+    };
+
+    enum class GatingInstructionSet{
+        scalar,
+        sse2, // 2 points per instruction
+        avx2, // 4 points per instruction
+        avx512 // 8 points per instruction
+    };
+
+    /**
+     * @brief widest instruction set supported by the cpu, detected once at the first call
+     */
+    GatingInstructionSet gatingInstructionSet();
+
+    const char* gatingInstructionSetName(const GatingInstructionSet&);
+
+    /**
+     * @brief squared distance to the anchor and in-box test for a batch of points in SoA layout, e.g. the points of the grid cells of one row of a search window.
+     * The distances are computed without fused multiply-add, so they are the same bit by bit for every instruction set.
+     * Points with a NaN coordinate are never inside the box - used to mask out taken points without a separate mask array
+     * @param query search window
+     * @param x x coordinates of the points
+     * @param y y coordinates of the points
+     * @param count number of points
+     * @param in_box output: 1 if the point lies inside the box, 0 otherwise
+     * @param sq_distance output: squared distance of each point to the anchor, only meaningful inside the box
+     */
+    void gateBox(const GatingQuery&, const double*, const double*, const int&, uint8_t*, double*);
+
+    /**
+     * @brief same as above, with an explicitly chosen instruction set - must be supported by the cpu
+     */
+    void gateBox(const GatingInstructionSet&, const GatingQuery&, const double*, const double*, const int&, uint8_t*, double*);
+
+} // uvdar
@@ -0,0 +1,216 @@
+#include "ami_instrumentation.h"
+
+namespace uvdar
+{
+
+    const char *stageName(const Stage &stage)
+    {
+        switch (stage)
+        {
+        case Stage::frame:
+            return "frame";
+        case Stage::local_search:
+            return "local_search";
+        case Stage::extended_search:
+            return "extended_search";
+        case Stage::regression:
+            return "regression";
+        case Stage::pruning:
+            return "pruning";
+        case Stage::matching:
+            return "matching";
+        default:
+            return "unknown";
+        }
+    }
+
+    int LatencyHistogram::bucket(const uint64_t &ns)
+    {
+        if (ns < (uint64_t(1) << sub_bucket_bits_))
+            return (int)ns;
+        // exponent and the next sub_bucket_bits_ bits below the highest set bit
+        const int msb = 63 - __builtin_clzll(ns);
+        const int sub = (int)((ns >> (msb - sub_bucket_bits_)) & ((1 << sub_bucket_bits_) - 1));
+        return ((msb - sub_bucket_bits_ + 1) << sub_bucket_bits_) + sub;
+    }
+
+    uint64_t LatencyHistogram::bucketUpperBound(const int &index)
+    {
+        if (index < (1 << sub_bucket_bits_))
+            return (uint64_t)index;
+        const int msb = (index >> sub_bucket_bits_) + sub_bucket_bits_ - 1;
+        const uint64_t sub = (uint64_t)(index & ((1 << sub_bucket_bits_) - 1));
+        const uint64_t lower = (uint64_t(1) << msb) | (sub << (msb - sub_bucket_bits_));
+        return lower + (uint64_t(1) << (msb - sub_bucket_bits_)) - 1;
+    }
+
+    void LatencyHistogram::record(const uint64_t &ns)
+    {
+        add(buckets_[bucket(ns)], 1);
+        add(calls_, 1);
+        add(total_ns_, ns);
+        if (ns > max_ns_.load(std::memory_order_relaxed))
+            max_ns_.store(ns, std::memory_order_relaxed);
+    }
+
+    void LatencyHistogram::reset()
+    {
+        for (auto &bucket : buckets_)
+            bucket.store(0, std::memory_order_relaxed);
+        calls_.store(0, std::memory_order_relaxed);
+        total_ns_.store(0, std::memory_order_relaxed);
+        max_ns_.store(0, std::memory_order_relaxed);
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram &other)
+    {
+        for (int i = 0; i < bucket_count_; ++i)
+            add(buckets_[i], other.buckets_[i].load(std::memory_order_relaxed));
+        add(calls_, other.calls_.load(std::memory_order_relaxed));
+        add(total_ns_, other.total_ns_.load(std::memory_order_relaxed));
+        const uint64_t other_max_ns = other.max_ns_.load(std::memory_order_relaxed);
+        if (other_max_ns > max_ns_.load(std::memory_order_relaxed))
+            max_ns_.store(other_max_ns, std::memory_order_relaxed);
+    }
+
+    StageStatistics LatencyHistogram::statistics() const
+    {
+        StageStatistics statistics;
+        statistics.calls = calls_.load(std::memory_order_relaxed);
+        statistics.total_ns = total_ns_.load(std::memory_order_relaxed);
+        statistics.max_ns = max_ns_.load(std::memory_order_relaxed);
+        if (statistics.calls == 0)
+            return statistics;
+
+        const uint64_t p50_rank = (statistics.calls + 1) / 2;
+        const uint64_t p99_rank = std::max<uint64_t>((statistics.calls * 99 + 99) / 100, 1);
+        uint64_t seen = 0;
+        for (int i = 0; i < bucket_count_; ++i)
+        {
+            const uint64_t n = buckets_[i].load(std::memory_order_relaxed);
+            if (n == 0)
+                continue;
+            if (seen < p50_rank && seen + n >= p50_rank)
+                statistics.p50_ns = std::min(bucketUpperBound(i), statistics.max_ns);
+            if (seen < p99_rank && seen + n >= p99_rank)
+                statistics.p99_ns = std::min(bucketUpperBound(i), statistics.max_ns);
+            seen += n;
+        }
+        return statistics;
+    }
+
+    TraceRing::TraceRing(const size_t &capacity) : capacity_(capacity)
+    {
+    }
+
+    void TraceRing::allocate()
+    {
+        if (allocated_.load(std::memory_order_acquire))
+            return;
+        size_t size = 1;
+        while (size < capacity_)
+            size <<= 1;
+        slots_ = std::make_unique<Slot[]>(size);
+        mask_ = size - 1;
+        allocated_.store(true, std::memory_order_release);
+    }
+
+    void TraceRing::push(const TraceEvent &event)
+    {
+        const uint64_t position = head_.load(std::memory_order_relaxed);
+        Slot &slot = slots_[position & mask_];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = event;
+        slot.sequence.store(position + 1, std::memory_order_release);
+        head_.store(position + 1, std::memory_order_release);
+    }
+
+    void TraceRing::snapshot(std::vector<TraceEvent> &events) const
+    {
+        events.clear();
+        if (!allocated_.load(std::memory_order_acquire))
+            return;
+        const uint64_t head = head_.load(std::memory_order_acquire);
+        const uint64_t begin = (head > mask_ + 1) ? head - (mask_ + 1) : 0;
+        events.reserve(head - begin);
+        for (uint64_t position = begin; position < head; ++position)
+        {
+            const Slot &slot = slots_[position & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+                continue;
+            TraceEvent event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // the writer overtook the reader while the event was copied
+            if (slot.sequence.load(std::memory_order_relaxed) != position + 1)
+                continue;
+            events.push_back(event);
+        }
+    }
+
+    bool TraceRing::dump(const std::string &path) const
+    {
+        std::vector<TraceEvent> events;
+        snapshot(events);
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        TraceFileHeader header;
+        std::memcpy(header.magic, "AMITRACE", sizeof(header.magic));
+        header.version = 1;
+        header.event_size = sizeof(TraceEvent);
+        header.event_count = events.size();
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(events.data()), events.size() * sizeof(TraceEvent));
+        return (bool)file;
+    }
+
+    Instrumentation::Instrumentation(const size_t &trace_capacity) : trace_(trace_capacity)
+    {
+    }
+
+    void Instrumentation::trace(const TraceEventType &type, const int64_t &stamp_ns, const uint32_t &track, const float &v0, const float &v1, const float &v2, const float &v3, const int32_t &count, const uint64_t &bits)
+    {
+        TraceEvent event;
+        event.stamp_ns = stamp_ns;
+        event.type = (uint32_t)type;
+        event.track = track;
+        event.values[0] = v0;
+        event.values[1] = v1;
+        event.values[2] = v2;
+        event.values[3] = v3;
+        event.count = count;
+        event.reserved = 0;
+        event.bits = bits;
+        trace_.push(event);
+    }
+
+    void Instrumentation::statistics(TrackerStatistics &statistics) const
+    {
+        for (int i = 0; i < (int)Stage::count; ++i)
+            statistics.stages[i] = stages_[i].statistics();
+        statistics.frames = counters_[frames].load(std::memory_order_relaxed);
+        statistics.points = counters_[points].load(std::memory_order_relaxed);
+        statistics.local_search_hits = counters_[local_search_hits].load(std::memory_order_relaxed);
+        statistics.extended_search_queries = counters_[extended_search_queries].load(std::memory_order_relaxed);
+        statistics.extended_search_hits = counters_[extended_search_hits].load(std::memory_order_relaxed);
+        statistics.regression_fits = counters_[regression_fits].load(std::memory_order_relaxed);
+        statistics.created_tracks = counters_[created_tracks].load(std::memory_order_relaxed);
+        statistics.pruned_tracks = counters_[pruned_tracks].load(std::memory_order_relaxed);
+        statistics.dropped_points = counters_[dropped_points].load(std::memory_order_relaxed);
+        statistics.degraded_frames = counters_[degraded_frames].load(std::memory_order_relaxed);
+        statistics.fallback_searches = counters_[fallback_searches].load(std::memory_order_relaxed);
+        statistics.deferred_prunings = counters_[deferred_prunings].load(std::memory_order_relaxed);
+        statistics.greedy_assignments = counters_[greedy_assignments].load(std::memory_order_relaxed);
+        statistics.trace_events = trace_.written();
+    }
+
+    void Instrumentation::reset()
+    {
+        for (auto &stage : stages_)
+            stage.reset();
+        for (auto &counter : counters_)
+            counter.store(0, std::memory_order_relaxed);
+    }
+
+} // uvdar
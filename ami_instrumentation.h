@@ -0,0 +1,237 @@
+#pragma once
+
+#include <bits/stdc++.h>
+
+namespace uvdar{
+
+    // instrumented stages of the processing of one frame
+    enum class Stage{
+        frame, // whole AMI::processFrame()
+        local_search, // findClosestPixelAndInsert() without the extended search
+        extended_search, // extendedSearch() including the regression
+        regression, // prediction of the search windows in the extended search
+        pruning, // cleanPotentialBuffer()
+        matching, // matching and publication of the results
+        count
+    };
+
+    const char* stageName(const Stage&);
+
+    struct StageStatistics{
+        uint64_t calls = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+        uint64_t p50_ns = 0; // upper bound of the histogram bucket, at most 12.5% above the exact value
+        uint64_t p99_ns = 0;
+    };
+
+    struct TrackerStatistics{
+        std::array<StageStatistics, (int)Stage::count> stages;
+        uint64_t frames = 0;
+        uint64_t points = 0; // points received in all frames
+        uint64_t local_search_hits = 0; // points inserted by the local search
+        uint64_t extended_search_queries = 0; // sequences passed to the extended search while unassigned points were left
+        uint64_t extended_search_hits = 0; // points inserted by the extended search
+        uint64_t regression_fits = 0; // regressions recomputed, the others were taken from the prediction cache
+        uint64_t created_tracks = 0;
+        uint64_t pruned_tracks = 0;
+        uint64_t dropped_points = 0; // points discarded because the buffer of sequences was full
+        uint64_t degraded_frames = 0; // frames with a reduced extended search
+        uint64_t fallback_searches = 0; // sequences searched in the fallback box instead of a predicted window
+        uint64_t deferred_prunings = 0;
+        uint64_t greedy_assignments = 0; // searches assigned greedily because of "assignment_exact_limit" or the frame budget
+        uint64_t trace_events = 0; // events written to the trace ring, including overwritten ones
+        int active_tracks = 0;
+        size_t memory_bytes = 0; // storage of the tracks, the frame index and the results
+
+        double extendedSearchHitRate() const { return extended_search_queries ? (double)extended_search_hits / extended_search_queries : 0.0; }
+    };
+
+    /**
+     * @brief latency histogram with 8 logarithmic buckets per power of two. Written by one thread, can be read concurrently
+     */
+    class LatencyHistogram{
+
+        private:
+            static constexpr int sub_bucket_bits_ = 3;
+            static constexpr int bucket_count_ = 64 << sub_bucket_bits_;
+
+            std::array<std::atomic<uint64_t>, bucket_count_> buckets_{};
+            std::atomic<uint64_t> calls_{0};
+            std::atomic<uint64_t> total_ns_{0};
+            std::atomic<uint64_t> max_ns_{0};
+
+            static int bucket(const uint64_t&);
+            static uint64_t bucketUpperBound(const int&);
+
+            // single writer - no read-modify-write instruction needed
+            static void add(std::atomic<uint64_t>& value, const uint64_t& n) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+
+        public:
+            void record(const uint64_t&);
+            void reset();
+            StageStatistics statistics() const;
+
+            /**
+             * @brief add the recorded values of another histogram, e.g. to combine the histograms of several streams. The other histogram may be written concurrently
+             */
+            void merge(const LatencyHistogram&);
+    };
+
+    // event types of the trace ring
+    enum class TraceEventType : uint32_t{
+        prediction = 1, // values: predicted x, predicted y, prediction interval x, y; count: number of points of the regression
+        extended_search_hit = 2, // values: x, y of the inserted point
+        track_created = 3, // values: x, y of the first point
+        track_pruned = 4, // count: number of stored points
+        points_dropped = 5, // count: number of discarded points
+        match = 6, // count: matched id, bits: newest led states
+    };
+
+    // binary record of the trace ring, the dump file is an array of these records (little endian) after a TraceFileHeader
+    struct TraceEvent{
+        int64_t stamp_ns; // stamp of the processed frame
+        uint32_t type; // TraceEventType
+        uint32_t track; // pool slot of the track, UINT32_MAX if none
+        float values[4];
+        int32_t count;
+        uint32_t reserved;
+        uint64_t bits;
+    };
+    static_assert(sizeof(TraceEvent) == 48, "the trace file layout must not change");
+
+    struct TraceFileHeader{
+        char magic[8]; // "AMITRACE"
+        uint32_t version;
+        uint32_t event_size;
+        uint64_t event_count;
+    };
+
+    /**
+     * @brief lock-free ring of the newest trace events. One thread writes, the oldest events are overwritten.
+     * A reader copies the events while the writer continues - every slot carries a sequence number, events overwritten during the copy are skipped.
+     * The slots are only allocated by allocate(), a ring of a tracker without tracing keeps no events
+     */
+    class TraceRing{
+
+        private:
+            struct Slot{
+                std::atomic<uint64_t> sequence{0}; // position + 1 of the event in the slot, 0 while it is written
+                TraceEvent event;
+            };
+
+            size_t capacity_;
+            std::unique_ptr<Slot[]> slots_;
+            uint64_t mask_ = 0;
+            std::atomic<bool> allocated_{false}; // publishes slots_ to the readers
+            std::atomic<uint64_t> head_{0}; // number of written events
+
+        public:
+            /**
+             * @param capacity number of kept events, rounded up to a power of two
+             */
+            TraceRing(const size_t&);
+
+            /**
+             * @brief allocate the slots, only the first call allocates - has to be called before the first push()
+             */
+            void allocate();
+
+            void push(const TraceEvent&);
+
+            /**
+             * @brief copy the kept events, oldest first
+             */
+            void snapshot(std::vector<TraceEvent>&) const;
+
+            /**
+             * @brief write the kept events to a binary file
+             * @return false if the file cannot be written
+             */
+            bool dump(const std::string&) const;
+
+            uint64_t written() const { return head_.load(std::memory_order_relaxed); }
+    };
+
+    /**
+     * @brief measures the time from construction to destruction into a histogram
+     */
+    class ScopedStageTimer{
+
+        private:
+            LatencyHistogram& histogram_;
+            std::chrono::steady_clock::time_point start_;
+
+        public:
+            ScopedStageTimer(LatencyHistogram& histogram) : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+            ~ScopedStageTimer() { histogram_.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count()); }
+    };
+
+    /**
+     * @brief stage histograms, event counters and the trace ring of one tracker.
+     * Used through the AMI_* macros below, which compile to nothing if AMI_DISABLE_INSTRUMENTATION is defined
+     */
+    class Instrumentation{
+
+        public:
+            enum Counter{
+                points,
+                local_search_hits,
+                extended_search_queries,
+                extended_search_hits,
+                regression_fits,
+                created_tracks,
+                pruned_tracks,
+                dropped_points,
+                frames,
+                degraded_frames,
+                fallback_searches,
+                deferred_prunings,
+                greedy_assignments,
+                counter_count
+            };
+
+        private:
+            std::array<LatencyHistogram, (int)Stage::count> stages_;
+            std::array<std::atomic<uint64_t>, counter_count> counters_{};
+            TraceRing trace_;
+
+        public:
+            Instrumentation(const size_t&);
+
+            LatencyHistogram& stage(const Stage& stage) { return stages_[(int)stage]; }
+
+            // may be called from the worker threads of the extended search
+            void count(const Counter& counter, const uint64_t& n) { counters_[counter].fetch_add(n, std::memory_order_relaxed); }
+
+            /**
+             * @brief allocate the trace ring, before the first trace event
+             */
+            void enableTrace() { trace_.allocate(); }
+
+            void trace(const TraceEventType&, const int64_t&, const uint32_t&, const float&, const float&, const float&, const float&, const int32_t&, const uint64_t&);
+
+            /**
+             * @brief fill the stage and counter fields of the statistics
+             */
+            void statistics(TrackerStatistics&) const;
+            void reset();
+
+            const TraceRing& traceRing() const { return trace_; }
+    };
+
+} // uvdar
+
+#ifndef AMI_DISABLE_INSTRUMENTATION
+#define AMI_CONCAT_IMPL(a, b) a##b
+#define AMI_CONCAT(a, b) AMI_CONCAT_IMPL(a, b)
+#define AMI_STAGE_TIMER(instrumentation, stage_id) uvdar::ScopedStageTimer AMI_CONCAT(ami_stage_timer_, __LINE__)((instrumentation).stage(stage_id))
+#define AMI_COUNT(instrumentation, counter, n) (instrumentation).count(uvdar::Instrumentation::counter, (n))
+#define AMI_TRACE(instrumentation, enabled, ...) do{ if(enabled) (instrumentation).trace(__VA_ARGS__); }while(0)
+#define AMI_ENABLE_TRACE(instrumentation) (instrumentation).enableTrace()
+#else
+#define AMI_STAGE_TIMER(instrumentation, stage_id) do{}while(0)
+#define AMI_COUNT(instrumentation, counter, n) do{}while(0)
+#define AMI_TRACE(instrumentation, enabled, ...) do{}while(0)
+#define AMI_ENABLE_TRACE(instrumentation) do{}while(0)
+#endif
@@ -0,0 +1,128 @@
+#include "ami_kalman_filter.h"
+#include <algorithm>
+
+namespace uvdar
+{
+
+    namespace
+    {
+        // prior of the derivatives at the first measurement - the first points of a track define them
+        constexpr double initial_velocity_variance = 1e6; // px^2/s^2
+        constexpr double initial_acceleration_variance = 1e8; // px^2/s^4
+
+        constexpr double factorial[] = {1.0, 1.0, 2.0, 6.0, 24.0, 120.0};
+    }
+
+    void KalmanFilter::reset()
+    {
+        x_ = Axis();
+        y_ = Axis();
+        states_ = 0;
+        measurements_ = 0;
+        stamp_ns_ = 0;
+    }
+
+    void KalmanFilter::predictAxis(const int &n, const double &dt, const double &process_noise, Axis &axis)
+    {
+        if (dt == 0.0)
+            return;
+
+        // F: state transition of the polynomial motion model, F(i, j) = dt^(j - i) / (j - i)!
+        double transition[max_states * max_states] = {};
+        double powers[2 * max_states] = {1.0};
+        for (int k = 1; k < 2 * max_states; ++k)
+            powers[k] = powers[k - 1] * dt;
+        for (int i = 0; i < n; ++i)
+            for (int j = i; j < n; ++j)
+                transition[i * max_states + j] = powers[j - i] / factorial[j - i];
+
+        std::array<double, max_states> state{};
+        for (int i = 0; i < n; ++i)
+            for (int j = i; j < n; ++j)
+                state[i] += transition[i * max_states + j] * axis.state[j];
+        axis.state = state;
+
+        // P = F P F^T + Q, Q of the white noise of the highest derivative: q * dt^(2n-1-i-j) / ((n-1-i)! (n-1-j)! (2n-1-i-j))
+        double fp[max_states * max_states] = {};
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j)
+                for (int k = i; k < n; ++k)
+                    fp[i * max_states + j] += transition[i * max_states + k] * axis.covariance[k * max_states + j];
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                double value = 0.0;
+                for (int k = j; k < n; ++k)
+                    value += fp[i * max_states + k] * transition[j * max_states + k];
+                const int exponent = 2 * n - 1 - i - j;
+                value += process_noise * powers[exponent] / (factorial[n - 1 - i] * factorial[n - 1 - j] * exponent);
+                axis.covariance[i * max_states + j] = value;
+            }
+        }
+    }
+
+    void KalmanFilter::updateAxis(const int &n, const double &measurement, const double &measurement_noise, Axis &axis)
+    {
+        // H = [1 0 0]: the gain is the first column of P scaled by the innovation variance
+        const double innovation = measurement - axis.state[0];
+        const double innovation_variance = axis.covariance[0] + measurement_noise;
+        double gain[max_states];
+        for (int i = 0; i < n; ++i)
+            gain[i] = axis.covariance[i * max_states] / innovation_variance;
+        for (int i = 0; i < n; ++i)
+            axis.state[i] += gain[i] * innovation;
+
+        double first_row[max_states];
+        for (int j = 0; j < n; ++j)
+            first_row[j] = axis.covariance[j];
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j)
+                axis.covariance[i * max_states + j] -= gain[i] * first_row[j];
+    }
+
+    void KalmanFilter::update(const int &states, const KalmanNoise &noise, const int64_t &stamp_ns, const double &x, const double &y)
+    {
+        if (states_ != states)
+        {
+            reset();
+            states_ = std::min(std::max(states, 1), max_states);
+            const double initial_variance[max_states] = {noise.measurement, initial_velocity_variance, initial_acceleration_variance};
+            for (Axis *axis : {&x_, &y_})
+            {
+                for (int i = 0; i < states_; ++i)
+                    axis->covariance[i * max_states + i] = initial_variance[i];
+            }
+            x_.state[0] = x;
+            y_.state[0] = y;
+            stamp_ns_ = stamp_ns;
+            measurements_ = 1;
+            return;
+        }
+
+        const double dt = (stamp_ns - stamp_ns_) * 1e-9;
+        predictAxis(states_, dt, noise.process, x_);
+        predictAxis(states_, dt, noise.process, y_);
+        updateAxis(states_, x, noise.measurement, x_);
+        updateAxis(states_, y, noise.measurement, y_);
+        stamp_ns_ = stamp_ns;
+        measurements_++;
+    }
+
+    bool KalmanFilter::predict(const KalmanNoise &noise, const int64_t &stamp_ns, std::array<double, max_states> &x, std::array<double, max_states> &y, double &var_x, double &var_y) const
+    {
+        if (states_ == 0)
+            return false;
+
+        const double dt = (stamp_ns - stamp_ns_) * 1e-9;
+        Axis x_axis = x_, y_axis = y_;
+        predictAxis(states_, dt, noise.process, x_axis);
+        predictAxis(states_, dt, noise.process, y_axis);
+        x = x_axis.state;
+        y = y_axis.state;
+        var_x = x_axis.covariance[0] + noise.measurement;
+        var_y = y_axis.covariance[0] + noise.measurement;
+        return true;
+    }
+
+} // uvdar
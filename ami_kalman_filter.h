@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace uvdar{
+
+    struct KalmanNoise{
+        double process; // spectral density of the white acceleration (constant velocity) or white jerk (constant acceleration)
+        double measurement; // variance of a measured coordinate in px^2
+    };
+
+    /**
+     * @brief linear Kalman filter of the image position of one track with a constant velocity (2 states per axis) or constant acceleration (3 states per axis) model.
+     * The x and y coordinates are filtered independently with the same model, so the covariance is block diagonal and one update costs a few dozen flops.
+     * Only "on"-points are measurements, between them the state is only extrapolated
+     */
+    class KalmanFilter{
+
+        public:
+            static constexpr int max_states = 3;
+
+        private:
+            struct Axis{
+                std::array<double, max_states> state{}; // position, velocity, acceleration
+                std::array<double, max_states * max_states> covariance{}; // row-major
+            };
+
+            Axis x_;
+            Axis y_;
+            int states_ = 0; // 0 until the first measurement
+            int measurements_ = 0;
+            int64_t stamp_ns_ = 0; // time of the state
+
+            /**
+             * @brief propagate the state and the covariance of one axis by dt seconds
+             */
+            static void predictAxis(const int&, const double&, const double&, Axis&);
+
+            /**
+             * @brief measurement update of one axis with the measured position
+             */
+            static void updateAxis(const int&, const double&, const double&, Axis&);
+
+        public:
+            void reset();
+
+            bool initialized() const { return states_ > 0; }
+            int64_t stampNs() const { return stamp_ns_; }
+
+            /**
+             * @brief predict the state to the time of the measurement and update it with the measured position
+             * @param states 2 for constant velocity, 3 for constant acceleration
+             * @param noise
+             * @param stamp_ns time of the measurement
+             * @param x
+             * @param y
+             */
+            void update(const int&, const KalmanNoise&, const int64_t&, const double&, const double&);
+
+            /**
+             * @brief extrapolated position and its variance including the measurement noise - the state of the filter is not changed
+             * @param noise
+             * @param stamp_ns time of the prediction
+             * @param x output: state (position, velocity, acceleration) of the x axis at stamp_ns
+             * @param y output: state of the y axis at stamp_ns
+             * @param var_x output: variance of the next measured x coordinate
+             * @param var_y output: variance of the next measured y coordinate
+             * @return false before the first measurement
+             */
+            bool predict(const KalmanNoise&, const int64_t&, std::array<double, max_states>&, std::array<double, max_states>&, double&, double&) const;
+
+            int states() const { return states_; }
+            int measurements() const { return measurements_; }
+    };
+
+} // uvdar
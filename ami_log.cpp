@@ -0,0 +1,34 @@
+#include "ami_log.h"
+#include <atomic>
+#include <cstdio>
+
+namespace uvdar
+{
+
+    namespace
+    {
+        void stderrSink(const LogLevel &level, const char *message)
+        {
+            const char *prefix = level == LogLevel::error ? "[ERROR] " : level == LogLevel::warn ? "[WARN] " : "[INFO] ";
+            std::fprintf(stderr, "%s%s\n", prefix, message);
+        }
+
+        std::atomic<LogSink> log_sink{&stderrSink};
+    }
+
+    void setLogSink(LogSink sink)
+    {
+        log_sink.store(sink ? sink : &stderrSink, std::memory_order_release);
+    }
+
+    void logMessage(const LogLevel &level, const char *format, ...)
+    {
+        char message[512];
+        va_list args;
+        va_start(args, format);
+        std::vsnprintf(message, sizeof(message), format, args);
+        va_end(args);
+        log_sink.load(std::memory_order_acquire)(level, message);
+    }
+
+} // namespace uvdar
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdarg>
+
+namespace uvdar{
+
+    enum class LogLevel{
+        info,
+        warn,
+        error
+    };
+
+    // receives every message of the tracker, called from the thread that logs - must be thread-safe
+    using LogSink = void (*)(const LogLevel&, const char*);
+
+    /**
+     * @brief route the messages of the tracker, e.g. to the ROS console (see useRosLogging() in ami_ros_adapter.h). By default they are written to stderr
+     * @param sink nullptr restores the default
+     */
+    void setLogSink(LogSink);
+
+    /**
+     * @brief format the message with printf syntax and pass it to the sink. Messages longer than 511 characters are truncated
+     * @param level severity of the message
+     * @param format printf format string
+     */
+    void logMessage(const LogLevel&, const char*, ...) __attribute__((format(printf, 2, 3)));
+
+} // uvdar
+
+#define AMI_LOG_INFO(...) uvdar::logMessage(uvdar::LogLevel::info, __VA_ARGS__)
+#define AMI_LOG_WARN(...) uvdar::logMessage(uvdar::LogLevel::warn, __VA_ARGS__)
+#define AMI_LOG_ERROR(...) uvdar::logMessage(uvdar::LogLevel::error, __VA_ARGS__)
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+namespace uvdar{
+
+    /**
+     * @brief non-owning view of the (x, y) image points of one frame. The coordinates are read in place from any contiguous layout -
+     * array of structs, interleaved or separate arrays - given by the address of the first x and y and the distance in bytes between two points.
+     * Coordinates can be double or float, the viewed memory must outlive the call it is passed to
+     */
+    class PointsView{
+
+        private:
+            const unsigned char* x_ = nullptr;
+            const unsigned char* y_ = nullptr;
+            std::size_t count_ = 0;
+            std::ptrdiff_t stride_ = 0; // bytes between two consecutive points
+            bool single_precision_ = false;
+
+            double read(const unsigned char* address) const {
+                if(single_precision_){
+                    float value;
+                    std::memcpy(&value, address, sizeof(float));
+                    return value;
+                }
+                double value;
+                std::memcpy(&value, address, sizeof(double));
+                return value;
+            }
+
+        public:
+            PointsView() = default;
+
+            /**
+             * @param x address of the x coordinate of the first point
+             * @param y address of the y coordinate of the first point
+             * @param count number of points
+             * @param stride bytes between two consecutive points
+             */
+            PointsView(const double* x, const double* y, std::size_t count, std::ptrdiff_t stride)
+                : x_(reinterpret_cast<const unsigned char*>(x)), y_(reinterpret_cast<const unsigned char*>(y)), count_(count), stride_(stride) {}
+            PointsView(const float* x, const float* y, std::size_t count, std::ptrdiff_t stride)
+                : x_(reinterpret_cast<const unsigned char*>(x)), y_(reinterpret_cast<const unsigned char*>(y)), count_(count), stride_(stride), single_precision_(true) {}
+
+            /**
+             * @brief view of an array of structs with "x" and "y" members, e.g. the points of a ROS message or cv::Point2f
+             */
+            template <typename Point>
+            static PointsView fromPoints(const Point* points, std::size_t count){
+                if(count == 0)
+                    return PointsView();
+                return PointsView(&points->x, &points->y, count, sizeof(Point));
+            }
+
+            /**
+             * @brief view of interleaved coordinates x0, y0, x1, y1, ...
+             */
+            template <typename Scalar>
+            static PointsView fromInterleaved(const Scalar* xy, std::size_t count){
+                if(count == 0)
+                    return PointsView();
+                return PointsView(xy, xy + 1, count, 2 * sizeof(Scalar));
+            }
+
+            /**
+             * @brief view of separate x and y arrays
+             */
+            template <typename Scalar>
+            static PointsView fromArrays(const Scalar* x, const Scalar* y, std::size_t count){
+                return PointsView(x, y, count, sizeof(Scalar));
+            }
+
+            std::size_t size() const { return count_; }
+            bool empty() const { return count_ == 0; }
+            double x(std::size_t i) const { return read(x_ + (std::ptrdiff_t)i * stride_); }
+            double y(std::size_t i) const { return read(y_ + (std::ptrdiff_t)i * stride_); }
+    };
+
+} // uvdar
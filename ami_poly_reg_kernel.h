@@ -0,0 +1,121 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <array>
+#include <cmath>
+
+namespace uvdar{
+
+    constexpr int max_poly_order = 3; // highest polynomial order supported by the regression kernel
+    constexpr int max_poly_reg_window = 128; // maximal number of (newest) points used for one regression
+
+    struct PolyFitXY{
+        std::array<double, max_poly_order + 1> coeff_x{};
+        std::array<double, max_poly_order + 1> coeff_y{};
+        int coeff_count = 0;
+        double wssr_x = 0.0; // weighted sum of squared residuals
+        double wssr_y = 0.0;
+        double time_scale = 1.0; // the polynomial is evaluated for time / time_scale
+    };
+
+    /**
+     * @brief weighted least squares fit of a polynomial of order "Order" for the x and y coordinate in one pass over the shared design matrix.
+     * The normal equations are accumulated in fixed-size matrices, the weights are applied as scalar factors - no heap allocation is done.
+     * The time values are expected to be centered (e.g. relative to the newest point) and are additionally scaled to [-1, 1] to keep the system well conditioned
+     * @param time independent values
+     * @param x x coordinates
+     * @param y y coordinates
+     * @param weights weight for each value
+     * @param n number of values, at most max_poly_reg_window
+     * @param fit output: coefficients and weighted sum of squared residuals
+     * @return false if the system could not be solved
+     */
+    template <int Order>
+    bool fitPolyXY(const double* time, const double* x, const double* y, const double* weights, int n, PolyFitXY& fit){
+        static_assert(0 <= Order && Order <= max_poly_order, "unsupported polynomial order");
+        constexpr int P = Order + 1;
+        using RowVect = Eigen::Matrix<double, P, 1>;
+
+        double time_scale = 0.0;
+        for(int i = 0; i < n; ++i){
+            time_scale = std::max(time_scale, std::abs(time[i]));
+        }
+        if(time_scale == 0.0) time_scale = 1.0;
+
+        Eigen::Matrix<double, P, P> normal_mat = Eigen::Matrix<double, P, P>::Zero();
+        Eigen::Matrix<double, P, 2> rhs = Eigen::Matrix<double, P, 2>::Zero();
+        for(int i = 0; i < n; ++i){
+            RowVect row;
+            row(0) = 1.0;
+            const double t = time[i] / time_scale;
+            for(int j = 1; j < P; ++j){
+                row(j) = row(j - 1) * t;
+            }
+            const RowVect weighted_row = weights[i] * row;
+            normal_mat.noalias() += weighted_row * row.transpose();
+            rhs.col(0).noalias() += weighted_row * x[i];
+            rhs.col(1).noalias() += weighted_row * y[i];
+        }
+
+        Eigen::LDLT<Eigen::Matrix<double, P, P>> solver(normal_mat);
+        if(solver.info() != Eigen::Success){
+            return false;
+        }
+        const Eigen::Matrix<double, P, 2> coeff = solver.solve(rhs);
+        if(!coeff.allFinite()){
+            return false;
+        }
+
+        fit.coeff_count = P;
+        fit.time_scale = time_scale;
+        for(int j = 0; j < P; ++j){
+            fit.coeff_x[j] = coeff(j, 0);
+            fit.coeff_y[j] = coeff(j, 1);
+        }
+
+        double wssr_x = 0.0, wssr_y = 0.0;
+        for(int i = 0; i < n; ++i){
+            const double t = time[i] / time_scale;
+            double pred_x = coeff(Order, 0), pred_y = coeff(Order, 1);
+            for(int j = Order - 1; j >= 0; --j){
+                pred_x = pred_x * t + coeff(j, 0);
+                pred_y = pred_y * t + coeff(j, 1);
+            }
+            wssr_x += weights[i] * (pred_x - x[i]) * (pred_x - x[i]);
+            wssr_y += weights[i] * (pred_y - y[i]) * (pred_y - y[i]);
+        }
+        fit.wssr_x = wssr_x;
+        fit.wssr_y = wssr_y;
+        return true;
+    }
+
+    /**
+     * @brief runtime dispatch of fitPolyXY() for the polynomial order
+     * @return false if the order is not supported or the system could not be solved
+     */
+    inline bool fitPolyXY(int order, const double* time, const double* x, const double* y, const double* weights, int n, PolyFitXY& fit){
+        if(n <= 0 || n > max_poly_reg_window) return false;
+        switch(order){
+            case 0: return fitPolyXY<0>(time, x, y, weights, n, fit);
+            case 1: return fitPolyXY<1>(time, x, y, weights, n, fit);
+            case 2: return fitPolyXY<2>(time, x, y, weights, n, fit);
+            case 3: return fitPolyXY<3>(time, x, y, weights, n, fit);
+            default: return false;
+        }
+    }
+
+    /**
+     * @brief evaluate the polynomial (Horner scheme)
+     * @param coeff coefficients, lowest order first
+     * @param coeff_count number of coefficients
+     * @param time already scaled independent value
+     */
+    inline double evaluatePoly(const std::array<double, max_poly_order + 1>& coeff, int coeff_count, double time){
+        double value = 0.0;
+        for(int j = coeff_count - 1; j >= 0; --j){
+            value = value * time + coeff[j];
+        }
+        return value;
+    }
+
+} // uvdar
@@ -0,0 +1,207 @@
+#include "ami_predictor.h"
+#include <boost/math/distributions/normal.hpp>
+
+namespace uvdar
+{
+
+    const char *predictorModeName(const PredictorMode &mode)
+    {
+        switch (mode)
+        {
+        case PredictorMode::recursive_least_squares:
+            return "rls";
+        case PredictorMode::constant_velocity:
+            return "cv";
+        case PredictorMode::constant_acceleration:
+            return "ca";
+        default:
+            return "poly";
+        }
+    }
+
+    RegressionPredictor::RegressionPredictor(std::shared_ptr<const SequenceTables> tables, const bool &recursive, const int &poly_order, const double &decay_factor, const double &conf_probab_percent)
+        : tables_(std::move(tables)), recursive_(recursive), poly_order_(poly_order), decay_factor_(decay_factor), conf_probab_percent_(conf_probab_percent)
+    {
+    }
+
+    void RegressionPredictor::insert(Track &sequence, const TrackSample &signal) const
+    {
+        if (!recursive_)
+        {
+            sequence.push(signal);
+            return;
+        }
+
+        RecursiveRegression &regression = sequence.regression();
+        if (sequence.size() == sequence.capacity() && sequence.ledState(0))
+        {
+            regression.remove(decay_factor_, sequence.stampNs(0), sequence.x(0), sequence.y(0));
+        }
+        sequence.push(signal);
+        if (!signal.led_state)
+            return;
+
+        if (!regression.needsRebuild(sequence.capacity()))
+        {
+            regression.add(decay_factor_, sequence.stampNs(sequence.size() - 1), sequence.x(sequence.size() - 1), sequence.y(sequence.size() - 1));
+            return;
+        }
+        regression.reset();
+        for (int i = 0; i < sequence.size(); ++i)
+        {
+            if (sequence.ledState(i))
+                regression.add(decay_factor_, sequence.stampNs(i), sequence.x(i), sequence.y(i));
+        }
+    }
+
+    bool RegressionPredictor::predict(Track &track, const int64_t &frame_stamp_ns, PredictionStatistics &x_statistics, PredictionStatistics &y_statistics, bool &fitted) const
+    {
+        PredictionCache &cache = track.predictionCache();
+        fitted = !cache.valid;
+        if (!cache.valid)
+        {
+            cache = PredictionCache();
+            if (recursive_)
+            {
+                fitRecursiveRegression(track, cache);
+            }
+            else
+            {
+                fitBatchRegression(track, cache);
+            }
+            cache.valid = true;
+        }
+        // without a solved regression there is no prediction, e.g. a singular system of equations
+        if (!cache.computed || !cache.solved)
+            return false;
+
+        // only the evaluation at the current time has to be done for every frame
+        const double insert_time = (frame_stamp_ns - cache.reference_ns) * 1e-9 + prediction_margin_;
+        x_statistics.coeff = cache.fit.coeff_x;
+        y_statistics.coeff = cache.fit.coeff_y;
+        x_statistics.wssr = cache.fit.wssr_x;
+        y_statistics.wssr = cache.fit.wssr_y;
+        for (auto statistics : {&x_statistics, &y_statistics})
+        {
+            statistics->time_pred = insert_time;
+            statistics->time_reference = cache.reference_ns * 1e-9;
+            statistics->mean_independent = cache.mean_time;
+            statistics->extended_search = true;
+            statistics->coeff_count = cache.fit.coeff_count;
+            statistics->time_scale = cache.fit.time_scale;
+            statistics->predicted_coordinate = evaluatePoly(statistics->coeff, statistics->coeff_count, insert_time / cache.fit.time_scale);
+            statistics->confidence_interval = tables_->extendedSearch().confidenceInterval(*statistics, cache.var_time, cache.n, conf_probab_percent_);
+            statistics->poly_reg_computed = true;
+        }
+        return true;
+    }
+
+    void RegressionPredictor::fitBatchRegression(const Track &track, PredictionCache &cache) const
+    {
+        // newest "on"-points of the track, filled from the back - times relative to the newest one
+        double x[max_poly_reg_window], y[max_poly_reg_window], time[max_poly_reg_window];
+        int n = 0;
+        for (int i = track.size() - 1; i >= 0 && n < max_poly_reg_window; --i)
+        {
+            if (!track.ledState(i))
+                continue;
+            if (n == 0)
+                cache.reference_ns = track.stampNs(i);
+            const int k = max_poly_reg_window - 1 - n;
+            x[k] = track.x(i);
+            y[k] = track.y(i);
+            time[k] = (track.stampNs(i) - cache.reference_ns) * 1e-9;
+            n++;
+        }
+        cache.n = n;
+        if (n <= 1)
+            return;
+
+        const int first = max_poly_reg_window - n;
+        double weights[max_poly_reg_window];
+        const ExtendedSearch &extended_search = tables_->extendedSearch();
+        extended_search.calcNormalizedWeights(time + first, n, weights);
+        cache.mean_time = extended_search.calcWeightedMean(time + first, weights, n);
+        for (int i = first; i < max_poly_reg_window; ++i)
+        {
+            cache.var_time += (time[i] - cache.mean_time) * (time[i] - cache.mean_time);
+        }
+
+        cache.solved = extended_search.polyRegXY(time + first, x + first, y + first, weights, n, regressionOrder(n), cache.fit);
+        cache.computed = true;
+    }
+
+    void RegressionPredictor::fitRecursiveRegression(const Track &track, PredictionCache &cache) const
+    {
+        const RecursiveRegression &regression = track.regression();
+        cache.n = regression.count();
+        cache.reference_ns = regression.referenceNs();
+        if (cache.n <= 1)
+            return;
+
+        cache.solved = regression.fit(regressionOrder(cache.n), cache.fit, cache.mean_time, cache.var_time);
+        cache.computed = true;
+    }
+
+    int RegressionPredictor::regressionOrder(const int &n) const
+    {
+        int poly_order = poly_order_;
+        if (0 < n && n < poly_order)
+        {
+            poly_order = n - 2;
+        }
+        // the order selection of the former AMI::selectStatisticsValues(), except for a window of exactly poly_order points: there the former
+        // QR solve of the underdetermined system left the highest coefficient at 0, i.e. it interpolated the points by a polynomial of order n - 1.
+        // The normal equations cannot be solved for more coefficients than points, so that order is fitted directly - the same polynomial up to rounding,
+        // and both have no degree of freedom left, so the confidence interval stays at its minimum "max_px_shift"
+        return std::clamp(poly_order, 0, std::max(n - 1, 0));
+    }
+
+    KalmanPredictor::KalmanPredictor(const PredictorMode &mode, const KalmanNoise &noise, const double &conf_probab_percent)
+    {
+        states_ = (mode == PredictorMode::constant_acceleration) ? 3 : 2;
+        noise_ = noise;
+        const double percentage_scaled = std::clamp(conf_probab_percent / 100.0, 0.01, 0.9999);
+        quantile_ = boost::math::quantile(boost::math::normal(), (1 - percentage_scaled) / 2 + percentage_scaled);
+    }
+
+    void KalmanPredictor::insert(Track &track, const TrackSample &sample) const
+    {
+        if (sample.led_state)
+            track.kalman().update(states_, noise_, sample.stamp_ns, sample.x, sample.y);
+        track.push(sample);
+    }
+
+    bool KalmanPredictor::predict(Track &track, const int64_t &frame_stamp_ns, PredictionStatistics &x_statistics, PredictionStatistics &y_statistics, bool &fitted) const
+    {
+        fitted = false;
+        // like the regression: a single point does not give a motion
+        if (track.kalman().measurements() < 2)
+            return false;
+        std::array<double, KalmanFilter::max_states> x_state, y_state;
+        double x_variance, y_variance;
+        if (!track.kalman().predict(noise_, frame_stamp_ns, x_state, y_state, x_variance, y_variance))
+            return false;
+
+        const std::array<double, KalmanFilter::max_states> *states[] = {&x_state, &y_state};
+        const double variances[] = {x_variance, y_variance};
+        PredictionStatistics *statistics[] = {&x_statistics, &y_statistics};
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            PredictionStatistics &axis_statistics = *statistics[axis];
+            axis_statistics.time_pred = 0.0;
+            axis_statistics.time_reference = frame_stamp_ns * 1e-9;
+            axis_statistics.time_scale = 1.0;
+            axis_statistics.mean_independent = 0.0;
+            axis_statistics.extended_search = true;
+            axis_statistics.coeff_count = states_;
+            for (int k = 0; k < states_; ++k)
+                axis_statistics.coeff[k] = (*states[axis])[k] / (k == 2 ? 2.0 : 1.0);
+            axis_statistics.predicted_coordinate = (*states[axis])[0];
+            axis_statistics.confidence_interval = quantile_ * std::sqrt(variances[axis]);
+            axis_statistics.poly_reg_computed = true; // the coefficients can be evaluated like the ones of the regression
+        }
+        return true;
+    }
+
+} // uvdar
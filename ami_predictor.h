@@ -0,0 +1,118 @@
+#pragma once
+
+#include "ami_sequence_tables.h"
+
+namespace uvdar{
+
+    enum class PredictorMode{
+        poly_regression, // weighted polynomial regression over the stored window, recomputed for every prediction
+        recursive_least_squares, // per-track sufficient statistics updated on insertion, O(p^2) per prediction
+        constant_velocity, // per-track Kalman filter with a constant velocity model, O(1) per insertion and prediction
+        constant_acceleration // per-track Kalman filter with a constant acceleration model
+    };
+
+    const char* predictorModeName(const PredictorMode&);
+
+    /**
+     * @brief predicts the position of a track in the current frame for the extended search. The per-track state of a predictor is stored in the Track,
+     * so a predictor itself is immutable and predict() can be called concurrently for different tracks
+     */
+    class Predictor{
+
+        public:
+            virtual ~Predictor(){}
+
+            /**
+             * @brief push the point to the end of the track and keep the per-track state of the predictor in sync
+             * @param track
+             * @param sample
+             */
+            virtual void insert(Track&, const TrackSample&) const = 0;
+
+            /**
+             * @brief predicted coordinates and the half widths of the prediction interval at the time of the frame. Only accesses the passed track
+             * @param track
+             * @param stamp_ns time stamp of the current frame
+             * @param x_statistics output for the x coordinate
+             * @param y_statistics output for the y coordinate
+             * @param fitted output: true if a regression had to be recomputed
+             * @return false if the track has too few points for a prediction or the fit failed
+             */
+            virtual bool predict(Track&, const int64_t&, PredictionStatistics&, PredictionStatistics&, bool&) const = 0;
+    };
+
+    /**
+     * @brief PredictorMode::poly_regression and PredictorMode::recursive_least_squares: weighted polynomial regression of the "on"-points with a Student-t prediction interval.
+     * The regression is taken from the prediction cache of the track and only recomputed if the cache was invalidated by a new or removed "on"-point
+     */
+    class RegressionPredictor : public Predictor{
+
+        private:
+            std::shared_ptr<const SequenceTables> tables_; // t-quantiles and weights of the regression
+            bool recursive_;
+            int poly_order_;
+            double decay_factor_;
+            double conf_probab_percent_;
+            const double prediction_margin_ = 0.0;
+
+            /**
+             * @brief weighted polynomial regression over the newest "on"-points of the track (at most max_poly_reg_window)
+             * @param track
+             * @param cache output
+             */
+            void fitBatchRegression(const Track&, PredictionCache&) const;
+
+            /**
+             * @brief solves the regression from the recursive least squares statistics of the track - O(p^2), independent of the number of stored points
+             * @param track track with up to date regression statistics
+             * @param cache output
+             */
+            void fitRecursiveRegression(const Track&, PredictionCache&) const;
+
+            /**
+             * @brief order of the polynomial for the regression over n points
+             */
+            int regressionOrder(const int&) const;
+
+        public:
+            /**
+             * @param tables
+             * @param recursive true for PredictorMode::recursive_least_squares
+             * @param poly_order
+             * @param decay_factor
+             * @param conf_probab_percent
+             */
+            RegressionPredictor(std::shared_ptr<const SequenceTables>, const bool&, const int&, const double&, const double&);
+
+            /**
+             * @brief in the recursive mode the statistics are downdated by the evicted point and updated by the new "on"-point
+             */
+            void insert(Track&, const TrackSample&) const override;
+            bool predict(Track&, const int64_t&, PredictionStatistics&, PredictionStatistics&, bool&) const override;
+    };
+
+    /**
+     * @brief PredictorMode::constant_velocity and PredictorMode::constant_acceleration: the KalmanFilter of the track is updated with every "on"-point,
+     * the prediction interval is the normal quantile of "conf_probab_percent" times the standard deviation of the predicted measurement.
+     * The statistics describe the extrapolated state as polynomial around the time of the frame (coefficients: position, velocity, acceleration / 2)
+     */
+    class KalmanPredictor : public Predictor{
+
+        private:
+            int states_;
+            KalmanNoise noise_;
+            double quantile_; // two-sided normal quantile of the prediction interval
+
+        public:
+            /**
+             * @param mode PredictorMode::constant_velocity or PredictorMode::constant_acceleration
+             * @param noise
+             * @param conf_probab_percent
+             */
+            KalmanPredictor(const PredictorMode&, const KalmanNoise&, const double&);
+
+            void insert(Track&, const TrackSample&) const override;
+            bool predict(Track&, const int64_t&, PredictionStatistics&, PredictionStatistics&, bool&) const override;
+    };
+
+} // uvdar
@@ -0,0 +1,140 @@
+#include "ami_recursive_regression.h"
+
+namespace uvdar
+{
+
+    void RecursiveRegression::reset()
+    {
+        *this = RecursiveRegression();
+    }
+
+    void RecursiveRegression::accumulate(double weight, double t, double x, double y)
+    {
+        double t_power = 1.0;
+        for (int k = 0; k < moments_; ++k)
+        {
+            w_t_[k] += weight * t_power;
+            if (k <= max_poly_order)
+            {
+                w_x_t_[k] += weight * x * t_power;
+                w_y_t_[k] += weight * y * t_power;
+            }
+            t_power *= t;
+        }
+        w_xx_ += weight * x * x;
+        w_yy_ += weight * y * y;
+    }
+
+    void RecursiveRegression::add(const double &decay_factor, const int64_t &stamp_ns, const double &x, const double &y)
+    {
+        if (count_ == 0)
+        {
+            reference_ns_ = stamp_ns;
+            last_ns_ = stamp_ns;
+            x_reference_ = x;
+            y_reference_ = y;
+        }
+
+        // decay the existing sums to the time of the new point
+        const double dt = std::max<int64_t>(stamp_ns - last_ns_, 0) * 1e-9;
+        if (dt > 0.0)
+        {
+            const double decay = exp(-decay_factor * dt);
+            for (auto &sum : w_t_)
+                sum *= decay;
+            for (int k = 0; k <= max_poly_order; ++k)
+            {
+                w_x_t_[k] *= decay;
+                w_y_t_[k] *= decay;
+            }
+            w_xx_ *= decay;
+            w_yy_ *= decay;
+            last_ns_ = stamp_ns;
+        }
+
+        const double t = (stamp_ns - reference_ns_) * 1e-9;
+        accumulate(1.0, t, x - x_reference_, y - y_reference_);
+        t_ += t;
+        tt_ += t * t;
+        count_++;
+        additions_since_reset_++;
+    }
+
+    void RecursiveRegression::remove(const double &decay_factor, const int64_t &stamp_ns, const double &x, const double &y)
+    {
+        if (count_ == 0)
+            return;
+        if (count_ == 1)
+        {
+            reset();
+            return;
+        }
+
+        const double weight = exp(-decay_factor * (last_ns_ - stamp_ns) * 1e-9);
+        const double t = (stamp_ns - reference_ns_) * 1e-9;
+        accumulate(-weight, t, x - x_reference_, y - y_reference_);
+        t_ -= t;
+        tt_ -= t * t;
+        count_--;
+    }
+
+    bool RecursiveRegression::fit(const int &poly_order, PolyFitXY &fit, double &mean_time, double &var_time) const
+    {
+        if (count_ == 0 || poly_order < 0 || poly_order > max_poly_order || w_t_[0] <= 0.0)
+            return false;
+
+        const int p = poly_order + 1;
+        const double sum_w = w_t_[0];
+        mean_time = w_t_[1] / sum_w;
+        var_time = std::max(tt_ - 2 * mean_time * t_ + count_ * mean_time * mean_time, 0.0);
+
+        // scale the time to unit RMS before solving - same conditioning as the batch kernel
+        double time_scale = std::sqrt(tt_ / count_);
+        if (!(time_scale > 0.0))
+            time_scale = 1.0;
+
+        Eigen::Matrix<double, max_poly_order + 1, max_poly_order + 1> normal_mat = Eigen::Matrix<double, max_poly_order + 1, max_poly_order + 1>::Identity();
+        Eigen::Matrix<double, max_poly_order + 1, 2> rhs = Eigen::Matrix<double, max_poly_order + 1, 2>::Zero();
+        std::array<double, moments_> scale_power;
+        scale_power[0] = 1.0;
+        for (int k = 1; k < moments_; ++k)
+            scale_power[k] = scale_power[k - 1] * time_scale;
+        for (int j = 0; j < p; ++j)
+        {
+            for (int k = 0; k < p; ++k)
+            {
+                normal_mat(j, k) = w_t_[j + k] / scale_power[j + k];
+            }
+            rhs(j, 0) = w_x_t_[j] / scale_power[j];
+            rhs(j, 1) = w_y_t_[j] / scale_power[j];
+        }
+
+        // the unused rows/cols form an identity block and yield zero coefficients
+        Eigen::LDLT<Eigen::Matrix<double, max_poly_order + 1, max_poly_order + 1>> solver(normal_mat);
+        if (solver.info() != Eigen::Success)
+            return false;
+        const Eigen::Matrix<double, max_poly_order + 1, 2> coeff = solver.solve(rhs);
+        if (!coeff.allFinite())
+            return false;
+
+        // weighted sum of squared residuals from the sums: y'Wy - 2 b'y + b'N b, normalized by the weight sum like the batch weights
+        const double wssr_x = w_xx_ - 2 * coeff.col(0).dot(rhs.col(0)) + coeff.col(0).dot(normal_mat * coeff.col(0));
+        const double wssr_y = w_yy_ - 2 * coeff.col(1).dot(rhs.col(1)) + coeff.col(1).dot(normal_mat * coeff.col(1));
+
+        fit.coeff_count = p;
+        fit.time_scale = time_scale;
+        fit.coeff_x.fill(0.0);
+        fit.coeff_y.fill(0.0);
+        for (int j = 0; j < p; ++j)
+        {
+            fit.coeff_x[j] = coeff(j, 0);
+            fit.coeff_y[j] = coeff(j, 1);
+        }
+        fit.coeff_x[0] += x_reference_;
+        fit.coeff_y[0] += y_reference_;
+        fit.wssr_x = std::max(wssr_x, 0.0) / sum_w;
+        fit.wssr_y = std::max(wssr_y, 0.0) / sum_w;
+        return true;
+    }
+
+} // uvdar
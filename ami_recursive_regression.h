@@ -0,0 +1,73 @@
+#pragma once
+
+#include "ami_poly_reg_kernel.h"
+#include <cstdint>
+
+namespace uvdar{
+
+    /**
+     * @brief sufficient statistics of the exponentially weighted polynomial regression of one track (recursive least squares with forgetting factor).
+     * The weighted power sums of the time and the coordinates are updated in O(1) for each inserted "on"-point and downdated when the point leaves the window of the track,
+     * the fit for any order up to max_poly_order is then solved from the sums in O(p^2) - independent of the window length.
+     * Time and coordinates are accumulated relative to a per-track reference to keep the sums well conditioned
+     */
+    class RecursiveRegression{
+
+        private:
+            static constexpr int moments_ = 2 * max_poly_order + 1;
+
+            int64_t reference_ns_ = 0; // time origin of the sums
+            int64_t last_ns_ = 0; // newest point - the weights are relative to this time
+            double x_reference_ = 0.0;
+            double y_reference_ = 0.0;
+            int count_ = 0;
+            int additions_since_reset_ = 0;
+
+            std::array<double, moments_> w_t_{}; // sum w * t^k
+            std::array<double, max_poly_order + 1> w_x_t_{}; // sum w * x * t^k
+            std::array<double, max_poly_order + 1> w_y_t_{}; // sum w * y * t^k
+            double w_xx_ = 0.0; // sum w * x^2
+            double w_yy_ = 0.0; // sum w * y^2
+            double t_ = 0.0; // unweighted sum t
+            double tt_ = 0.0; // unweighted sum t^2
+
+            void accumulate(double, double, double, double);
+
+        public:
+            void reset();
+
+            /**
+             * @brief add a new "on"-point - the existing weights are decayed to the time of the new point
+             * @param decay_factor decay of the exponential weights
+             * @param stamp_ns time of the point
+             * @param x
+             * @param y
+             */
+            void add(const double&, const int64_t&, const double&, const double&);
+
+            /**
+             * @brief remove an "on"-point that leaves the window of the track
+             */
+            void remove(const double&, const int64_t&, const double&, const double&);
+
+            /**
+             * @brief solve the weighted regression of the given order from the sums
+             * @param poly_order order of the polynomial, at most max_poly_order and lower than count()
+             * @param fit coefficients (with the coordinate reference already added) + normalized weighted sum of squared residuals for x and y
+             * @param mean_time weighted mean of the time values
+             * @param var_time sum of the squared deviations of the time values from mean_time
+             * @return false if the system could not be solved
+             */
+            bool fit(const int&, PolyFitXY&, double&, double&) const;
+
+            int count() const { return count_; }
+            int64_t referenceNs() const { return reference_ns_; }
+
+            /**
+             * @brief the sums should be rebuilt from the window once the window was turned over completely, this keeps the time values small and removes the drift of the downdates
+             * @param capacity capacity of the track
+             */
+            bool needsRebuild(const int& capacity) const { return additions_since_reset_ > capacity; }
+    };
+
+} // uvdar
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "ami_tracker_host.h"
+#include <ros/ros.h>
+#include <uvdar_core/ImagePointsWithFloatStamped.h>
+
+// adapters between the ROS-free tracker and ROS - only included by the ROS node, the tracker itself builds without ROS
+namespace uvdar{
+
+    inline int64_t toStampNs(const ros::Time& time) { return (int64_t)time.toNSec(); }
+
+    inline ros::Time toRosTime(const int64_t& stamp_ns) { return ros::Time().fromNSec(stamp_ns); }
+
+    /**
+     * @brief called by blink processor - adapter of AMI::submitFrame() for the ROS message, the points are read directly from the message
+     * @param ami tracker
+     * @param pts_msg points in mrs_msgs format
+     */
+    inline void processBuffer(AMI& ami, const uvdar_core::ImagePointsWithFloatStampedConstPtr pts_msg){
+        ami.submitFrame(PointsView::fromPoints(pts_msg->points.data(), pts_msg->points.size()), toStampNs(pts_msg->stamp));
+    }
+
+    /**
+     * @brief adapter of TrackerHost::submitFrame() for the ROS message
+     * @param host tracker host
+     * @param stream index of the camera
+     * @param pts_msg points in mrs_msgs format
+     */
+    inline void processBuffer(TrackerHost& host, const int& stream, const uvdar_core::ImagePointsWithFloatStampedConstPtr pts_msg){
+        host.submitFrame(stream, PointsView::fromPoints(pts_msg->points.data(), pts_msg->points.size()), toStampNs(pts_msg->stamp));
+    }
+
+    /**
+     * @brief the time is the ROS time when the frame is processed
+     */
+    class RosClock : public Clock{
+        public:
+            int64_t nowNs(const int64_t&) override { return toStampNs(ros::Time::now()); }
+    };
+
+    inline void rosLogSink(const LogLevel& level, const char* message){
+        switch(level){
+            case LogLevel::error:
+                ROS_ERROR("%s", message);
+                break;
+            case LogLevel::warn:
+                ROS_WARN("%s", message);
+                break;
+            default:
+                ROS_INFO("%s", message);
+        }
+    }
+
+    /**
+     * @brief route the messages of the tracker to the ROS console
+     */
+    inline void useRosLogging() { setLogSink(&rosLogSink); }
+
+} // uvdar
@@ -0,0 +1,127 @@
+#include "ami_scene_generator.h"
+
+namespace uvdar
+{
+
+    SceneGenerator::SceneGenerator(const SceneParams &params) : params_(params), rng_(params.seed)
+    {
+        const double area = std::max((double)params_.min_width * params_.min_height, params_.area_per_marker * params_.markers);
+        const double aspect = (double)params_.min_width / params_.min_height;
+        width_ = std::max((double)params_.min_width, std::sqrt(area * aspect));
+        height_ = std::max((double)params_.min_height, std::sqrt(area / aspect));
+
+        markers_.reserve(params_.markers);
+        for (int i = 0; i < params_.markers; ++i)
+        {
+            SceneMarker marker;
+            marker.x = uniform(0.0, width_);
+            marker.y = uniform(0.0, height_);
+            const double speed = uniform(0.0, params_.max_speed);
+            const double heading = uniform(0.0, 2 * M_PI);
+            marker.vx = speed * std::cos(heading);
+            marker.vy = speed * std::sin(heading);
+            marker.turn_rate = 0.0;
+            marker.sequence_id = params_.sequences.empty() ? 0 : i % (int)params_.sequences.size();
+            const int length = params_.sequences.empty() ? 1 : (int)params_.sequences[marker.sequence_id].size();
+            marker.phase = std::uniform_int_distribution<int>(0, std::max(length - 1, 0))(rng_);
+            marker.occluded_frames = 0;
+            markers_.push_back(marker);
+        }
+        points_.reserve(params_.markers + (int)std::ceil(params_.false_positives * 4) + 16);
+    }
+
+    SceneGenerator::~SceneGenerator()
+    {
+    }
+
+    double SceneGenerator::uniform(const double &min, const double &max)
+    {
+        return std::uniform_real_distribution<double>(min, max)(rng_);
+    }
+
+    void SceneGenerator::moveMarker(SceneMarker &marker)
+    {
+        if (params_.motion == MotionModel::agile)
+        {
+            // random walk of the turn rate, the speed is kept
+            marker.turn_rate = std::clamp(marker.turn_rate + uniform(-0.2, 0.2) * params_.max_turn_rate, -params_.max_turn_rate, params_.max_turn_rate);
+            const double c = std::cos(marker.turn_rate), s = std::sin(marker.turn_rate);
+            const double vx = c * marker.vx - s * marker.vy;
+            marker.vy = s * marker.vx + c * marker.vy;
+            marker.vx = vx;
+        }
+        marker.x += marker.vx;
+        marker.y += marker.vy;
+        if (marker.x < 0 || marker.x >= width_)
+        {
+            marker.vx = -marker.vx;
+            marker.x = std::clamp(marker.x, 0.0, width_ - 1);
+        }
+        if (marker.y < 0 || marker.y >= height_)
+        {
+            marker.vy = -marker.vy;
+            marker.y = std::clamp(marker.y, 0.0, height_ - 1);
+        }
+    }
+
+    const std::vector<ScenePoint> &SceneGenerator::nextFrame()
+    {
+        frame_number_++;
+        points_.clear();
+        std::normal_distribution<double> jitter(0.0, params_.jitter_px);
+        for (int i = 0; i < (int)markers_.size(); ++i)
+        {
+            SceneMarker &marker = markers_[i];
+            if (frame_number_ > 0)
+                moveMarker(marker);
+
+            if (marker.occluded_frames > 0)
+                marker.occluded_frames--;
+            else if (params_.occlusion_probability > 0 && uniform(0.0, 1.0) < params_.occlusion_probability)
+                marker.occluded_frames = params_.occlusion_frames;
+
+            if (!emits(i))
+                continue;
+            ScenePoint point{marker.x, marker.y, i};
+            if (params_.motion == MotionModel::jitter)
+            {
+                point.x += jitter(rng_);
+                point.y += jitter(rng_);
+            }
+            points_.push_back(point);
+        }
+
+        int false_positives = 0;
+        if (params_.false_positives > 0)
+            false_positives = std::poisson_distribution<int>(params_.false_positives)(rng_);
+        for (int i = 0; i < false_positives; ++i)
+        {
+            points_.push_back(ScenePoint{uniform(0.0, width_), uniform(0.0, height_), -1});
+        }
+
+        if (params_.integer_pixels)
+        {
+            for (auto &point : points_)
+            {
+                point.x = std::floor(point.x);
+                point.y = std::floor(point.y);
+            }
+        }
+        return points_;
+    }
+
+    int64_t SceneGenerator::frameStampNs() const
+    {
+        return (int64_t)1700000000 * 1000000000 + (int64_t)std::llround(frame_number_ * 1e9 / params_.framerate);
+    }
+
+    bool SceneGenerator::emits(const int &index) const
+    {
+        const SceneMarker &marker = markers_[index];
+        if (marker.occluded_frames > 0 || params_.sequences.empty())
+            return false;
+        const std::vector<bool> &sequence = params_.sequences[marker.sequence_id];
+        return sequence[(frame_number_ + marker.phase) % (int64_t)sequence.size()];
+    }
+
+} // uvdar
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <bits/stdc++.h>
+
+namespace uvdar{
+
+    enum class MotionModel{
+        linear, // constant velocity, reflected at the image borders
+        agile, // the heading turns with a randomly changing turn rate
+        jitter // constant velocity with gaussian noise on the emitted positions
+    };
+
+    // configuration of the synthetic scene
+    struct SceneParams{
+        int markers = 10;
+        std::vector<std::vector<bool>> sequences; // blink sequences, marker i emits sequence i % size
+        MotionModel motion = MotionModel::linear;
+        double framerate = 60.0;
+        double area_per_marker = 4000.0; // image area in px^2 per marker, the image grows for many markers
+        int min_width = 752; // minimal image size - UVDAR camera resolution
+        int min_height = 480;
+        double max_speed = 2.0; // px per frame
+        double max_turn_rate = 0.1; // rad per frame, for MotionModel::agile
+        double jitter_px = 0.7; // standard deviation of the position noise, for MotionModel::jitter
+        double false_positives = 0.0; // mean number of random points per frame
+        double occlusion_probability = 0.0; // probability per marker and frame that an occlusion starts
+        int occlusion_frames = 10; // length of an occlusion
+        bool integer_pixels = true; // round the emitted points to pixel positions like the blob detector
+        uint32_t seed = 42;
+    };
+
+    struct SceneMarker{
+        double x;
+        double y;
+        double vx; // px per frame
+        double vy;
+        double turn_rate; // rad per frame
+        int sequence_id;
+        int phase; // offset into the blink sequence
+        int occluded_frames; // remaining frames of the current occlusion
+    };
+
+    // point of a generated frame
+    struct ScenePoint{
+        double x;
+        double y;
+        int marker; // index of the emitting marker, -1 for a false positive
+    };
+
+    /**
+     * @brief deterministic generator of frames with moving blinking markers. Every marker emits its blink sequence with a random phase, moves by the motion model
+     * and is hidden while it is occluded. False positives are scattered uniformly over the image
+     */
+    class SceneGenerator{
+
+        private:
+            SceneParams params_;
+            double width_;
+            double height_;
+            std::mt19937 rng_;
+            std::vector<SceneMarker> markers_;
+            std::vector<ScenePoint> points_;
+            int64_t frame_number_ = -1;
+
+            void moveMarker(SceneMarker&);
+            double uniform(const double&, const double&);
+
+        public:
+            SceneGenerator(const SceneParams&);
+            ~SceneGenerator();
+
+            /**
+             * @brief advance the scene by one frame
+             * @return points of the new frame, valid until the next call
+             */
+            const std::vector<ScenePoint>& nextFrame();
+
+            /**
+             * @brief stamp of the current frame in nanoseconds
+             */
+            int64_t frameStampNs() const;
+
+            /**
+             * @brief ground truth of the current frame
+             */
+            const std::vector<SceneMarker>& markers() const { return markers_; }
+
+            /**
+             * @brief true if the marker is visible and its led is on in the current frame
+             */
+            bool emits(const int&) const;
+
+            double width() const { return width_; }
+            double height() const { return height_; }
+    };
+
+} // uvdar
@@ -0,0 +1,42 @@
+#include "ami_sequence_tables.h"
+
+namespace uvdar
+{
+
+    SequenceTables::SequenceTables(const std::vector<std::vector<bool>> &sequences, const int &allowed_BER, const int &stored_seq_len_factor, const double &decay_factor, const double &conf_probab_percent)
+        : original_sequences_(sequences), extended_search_(decay_factor)
+    {
+        matcher_ = std::make_unique<SignalMatcher>(original_sequences_, allowed_BER, true);
+        if (BitSignalMatcher::supports(original_sequences_))
+        {
+            bit_matcher_ = std::make_unique<BitSignalMatcher>(original_sequences_, allowed_BER);
+        }
+        if (original_sequences_.empty())
+            return;
+
+        track_capacity_ = stored_seq_len_factor * (int)original_sequences_[0].size();
+        extended_search_.precomputeTQuantiles(track_capacity_, conf_probab_percent);
+    }
+
+    SequenceTables::~SequenceTables()
+    {
+    }
+
+    int SequenceTables::matchSignal(const Track &sequence) const
+    {
+        if (bit_matcher_)
+        {
+            return bit_matcher_->matchSignal(sequence.ledHistory(), std::min(sequence.size(), 64));
+        }
+
+        std::vector<bool> led_states;
+        int first = std::max(0, sequence.size() - (int)original_sequences_[0].size());
+        for (int i = first; i < sequence.size(); ++i)
+        {
+            led_states.push_back(sequence.ledState(i));
+        }
+        std::scoped_lock lock(mutex_matcher_);
+        return matcher_->matchSignal(led_states);
+    }
+
+} // uvdar
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <bits/stdc++.h>
+#include "ami_bit_signal_matcher.h"
+#include "ami_extended_search.h"
+#include "ami_track.h"
+#include "signal_matcher/signal_matcher.h"
+
+namespace uvdar{
+
+    /**
+     * @brief read-only tables derived from the original sequences: the packed cyclic shifts for the matching and the Student-t quantiles of the extended search.
+     * Built once by setSequences() and shared by all trackers with the same sequences and parameters, e.g. the camera streams of a TrackerHost
+     */
+    class SequenceTables{
+
+        private:
+            std::vector<std::vector<bool>> original_sequences_;
+            int track_capacity_ = 0;
+            std::unique_ptr<BitSignalMatcher> bit_matcher_; // nullptr if the sequences do not fit into one word
+            std::unique_ptr<SignalMatcher> matcher_; // fallback for sequences longer than 64 bits
+            mutable std::mutex mutex_matcher_; // SignalMatcher is not const, serializes the fallback
+            ExtendedSearch extended_search_;
+
+        public:
+            /**
+             * @param sequences original sequences, all of the same length
+             * @param allowed_BER allowed number of bit errors per sequence
+             * @param stored_seq_len_factor number of points stored per track as multiple of the sequence length
+             * @param decay_factor of the weights of the regression
+             * @param conf_probab_percent percentage of the prediction interval
+             */
+            SequenceTables(const std::vector<std::vector<bool>>&, const int&, const int&, const double&, const double&);
+            ~SequenceTables();
+
+            /**
+             * @brief match the newest led states of the track against the original sequences, by popcount on the packed history if possible. Thread-safe
+             * @return id of the matched sequence, -1 if no sequence matches
+             */
+            int matchSignal(const Track&) const;
+
+            const ExtendedSearch& extendedSearch() const { return extended_search_; }
+            const std::vector<std::vector<bool>>& sequences() const { return original_sequences_; }
+
+            /**
+             * @brief number of points stored per track: length of the sequence * stored_seq_len_factor, 0 without sequences
+             */
+            int trackCapacity() const { return track_capacity_; }
+    };
+
+} // uvdar
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <bits/stdc++.h>
+
+namespace uvdar{
+
+    // start of a tracker snapshot, the records follow in the order written by AMI::saveSnapshot()
+    struct SnapshotHeader{
+        char magic[8]; // "AMISNAP"
+        uint32_t version;
+        uint32_t layout; // hash of the sizes of the raw records, snapshots are only exchanged between identical builds
+        uint64_t payload_size; // bytes after the header
+        uint64_t checksum; // snapshotChecksum() of the payload
+    };
+
+    /**
+     * @brief FNV-1a hash of the payload, detects damaged files before any record is interpreted
+     */
+    inline uint64_t snapshotChecksum(const uint8_t* data, const size_t& size){
+        uint64_t hash = 14695981039346656037ull;
+        for(size_t i = 0; i < size; ++i)
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        return hash;
+    }
+
+    /**
+     * @brief appends trivially copyable records to a byte buffer. The buffer is reused, no allocation once it reached the size of a snapshot
+     */
+    class SnapshotWriter{
+
+        private:
+            std::vector<uint8_t>& buffer_;
+
+        public:
+            SnapshotWriter(std::vector<uint8_t>& buffer) : buffer_(buffer) {}
+
+            template <typename T>
+            void write(const T& value){
+                writeArray(&value, 1);
+            }
+
+            template <typename T>
+            void writeArray(const T* values, const size_t& count){
+                static_assert(std::is_trivially_copyable<T>::value, "only raw records can be written");
+                const size_t offset = buffer_.size();
+                buffer_.resize(offset + count * sizeof(T));
+                if(count > 0)
+                    std::memcpy(buffer_.data() + offset, values, count * sizeof(T));
+            }
+
+            // a bool is written as one byte 0 or 1
+            void writeFlag(const bool& value){
+                write((uint8_t)value);
+            }
+
+            size_t size() const { return buffer_.size(); }
+            uint8_t* data() { return buffer_.data(); }
+    };
+
+    /**
+     * @brief reads the records of a SnapshotWriter in the same order, every read is bounds checked - after a failed read all further reads fail
+     */
+    class SnapshotReader{
+
+        private:
+            const uint8_t* data_;
+            size_t size_;
+            size_t position_ = 0;
+            bool ok_ = true;
+
+        public:
+            SnapshotReader(const uint8_t* data, const size_t& size) : data_(data), size_(size) {}
+
+            template <typename T>
+            bool read(T& value){
+                return readArray(&value, 1);
+            }
+
+            template <typename T>
+            bool readArray(T* values, const size_t& count){
+                static_assert(std::is_trivially_copyable<T>::value, "only raw records can be read");
+                if(!ok_ || count > (size_ - position_) / sizeof(T)){
+                    ok_ = false;
+                    return false;
+                }
+                if(count > 0)
+                    std::memcpy(values, data_ + position_, count * sizeof(T));
+                position_ += count * sizeof(T);
+                return true;
+            }
+
+            /**
+             * @brief read a flag written by SnapshotWriter::writeFlag(), any other byte than 0 or 1 fails
+             */
+            bool readFlag(bool& value){
+                uint8_t byte = 0;
+                if(!read(byte) || byte > 1){
+                    ok_ = false;
+                    return false;
+                }
+                value = byte;
+                return true;
+            }
+
+            /**
+             * @brief read a raw record with bool members, the bytes of the bools are checked before the record is copied - any other value than 0 or 1 fails
+             * @param value output
+             * @param flag_offsets offsetof() of the bool members
+             */
+            template <typename T>
+            bool readRecord(T& value, std::initializer_list<size_t> flag_offsets){
+                static_assert(std::is_trivially_copyable<T>::value, "only raw records can be read");
+                if(!ok_ || sizeof(T) > size_ - position_){
+                    ok_ = false;
+                    return false;
+                }
+                for(size_t offset : flag_offsets){
+                    if(data_[position_ + offset] > 1){
+                        ok_ = false;
+                        return false;
+                    }
+                }
+                return read(value);
+            }
+
+            bool ok() const { return ok_; }
+            size_t remaining() const { return size_ - position_; }
+    };
+
+} // uvdar
@@ -0,0 +1,155 @@
+#include "ami_spatial_grid.h"
+
+namespace uvdar
+{
+
+    SpatialGrid::SpatialGrid(const cv::Point &min_cell_size)
+    {
+        min_cell_size_ = cv::Point2d(std::max(min_cell_size.x, 1), std::max(min_cell_size.y, 1));
+        cell_size_ = min_cell_size_;
+    }
+
+    SpatialGrid::~SpatialGrid()
+    {
+    }
+
+    void SpatialGrid::build(const PointsView &frame)
+    {
+        points_.resize(frame.size());
+        for (std::size_t i = 0; i < frame.size(); ++i)
+        {
+            points_[i] = cv::Point2d(frame.x(i), frame.y(i));
+        }
+        bucketPoints();
+    }
+
+    void SpatialGrid::bucketPoints()
+    {
+        const int n = (int)points_.size();
+        taken_.assign(n, false);
+        remaining_ = n;
+        cell_of_point_.resize(n);
+        sorted_idx_.resize(n);
+        sorted_x_.resize(n);
+        sorted_y_.resize(n);
+        sorted_pos_.resize(n);
+
+        if (n == 0)
+        {
+            cols_ = rows_ = 0;
+            cell_start_.assign(1, 0);
+            return;
+        }
+
+        double min_x = points_[0].x, max_x = points_[0].x;
+        double min_y = points_[0].y, max_y = points_[0].y;
+        for (const auto &p : points_)
+        {
+            min_x = std::min(min_x, p.x);
+            max_x = std::max(max_x, p.x);
+            min_y = std::min(min_y, p.y);
+            max_y = std::max(max_y, p.y);
+        }
+        origin_ = cv::Point2d(min_x, min_y);
+
+        // keep the number of cells proportional to the number of points, otherwise clearing the grid dominates sparse frames
+        cell_size_ = min_cell_size_;
+        const double max_cells = 4.0 * n + 16.0;
+        double cells = (std::floor((max_x - min_x) / cell_size_.x) + 1) * (std::floor((max_y - min_y) / cell_size_.y) + 1);
+        if (cells > max_cells)
+        {
+            double scale = std::sqrt(cells / max_cells);
+            cell_size_ = cv::Point2d(cell_size_.x * scale, cell_size_.y * scale);
+        }
+        cols_ = (int)std::floor((max_x - min_x) / cell_size_.x) + 1;
+        rows_ = (int)std::floor((max_y - min_y) / cell_size_.y) + 1;
+
+        // counting sort of the point indices by cell
+        cell_start_.assign(cols_ * rows_ + 1, 0);
+        for (int i = 0; i < n; ++i)
+        {
+            cell_of_point_[i] = cellRow(points_[i].y) * cols_ + cellCol(points_[i].x);
+            cell_start_[cell_of_point_[i] + 1]++;
+        }
+        for (int c = 0; c < cols_ * rows_; ++c)
+        {
+            cell_start_[c + 1] += cell_start_[c];
+        }
+        fill_pos_.assign(cell_start_.begin(), cell_start_.end() - 1);
+        for (int i = 0; i < n; ++i)
+        {
+            const int pos = fill_pos_[cell_of_point_[i]]++;
+            sorted_idx_[pos] = i;
+            sorted_x_[pos] = points_[i].x;
+            sorted_y_[pos] = points_[i].y;
+            sorted_pos_[i] = pos;
+        }
+    }
+
+    int SpatialGrid::cellCol(double x) const
+    {
+        int col = (int)std::floor((x - origin_.x) / cell_size_.x);
+        return std::clamp(col, 0, cols_ - 1);
+    }
+
+    int SpatialGrid::cellRow(double y) const
+    {
+        int row = (int)std::floor((y - origin_.y) / cell_size_.y);
+        return std::clamp(row, 0, rows_ - 1);
+    }
+
+    void SpatialGrid::candidatesInBox(const cv::Point2d &anchor, const cv::Point2d &left_top, const cv::Point2d &right_bottom, std::vector<GatingCandidate> &candidates) const
+    {
+        if (!std::isfinite(left_top.x) || !std::isfinite(left_top.y) || !std::isfinite(right_bottom.x) || !std::isfinite(right_bottom.y))
+            return;
+        if (remaining_ == 0 || right_bottom.x < origin_.x || right_bottom.y < origin_.y)
+            return;
+        if (left_top.x > origin_.x + cols_ * cell_size_.x || left_top.y > origin_.y + rows_ * cell_size_.y)
+            return;
+
+        const int col_begin = cellCol(left_top.x), col_end = cellCol(right_bottom.x);
+        const int row_begin = cellRow(left_top.y), row_end = cellRow(right_bottom.y);
+
+        const GatingQuery query{anchor.x, anchor.y, left_top.x, left_top.y, right_bottom.x, right_bottom.y};
+        // results of one call of the gating kernel on the stack - the tiles of the local search call this concurrently
+        constexpr int chunk_size = 64;
+        uint8_t in_box[chunk_size];
+        double sq_distance[chunk_size];
+        for (int row = row_begin; row <= row_end; ++row)
+        {
+            const int end = cell_start_[row * cols_ + col_end + 1];
+            for (int begin = cell_start_[row * cols_ + col_begin]; begin < end; begin += chunk_size)
+            {
+                const int count = std::min(chunk_size, end - begin);
+                // a taken point has a NaN coordinate and fails the test
+                gateBox(query, sorted_x_.data() + begin, sorted_y_.data() + begin, count, in_box, sq_distance);
+                for (int i = 0; i < count; ++i)
+                {
+                    if (!in_box[i])
+                        continue;
+                    GatingCandidate candidate;
+                    candidate.sq_distance = sq_distance[i];
+                    candidate.index = sorted_idx_[begin + i];
+                    candidates.push_back(candidate);
+                }
+            }
+        }
+    }
+
+    void SpatialGrid::take(int index)
+    {
+        if (!taken_[index])
+        {
+            taken_[index] = true;
+            remaining_--;
+            sorted_x_[sorted_pos_[index]] = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    size_t SpatialGrid::memoryBytes() const
+    {
+        return (cell_start_.capacity() + sorted_idx_.capacity() + sorted_pos_.capacity() + cell_of_point_.capacity() + fill_pos_.capacity()) * sizeof(int) +
+               (sorted_x_.capacity() + sorted_y_.capacity()) * sizeof(double) + points_.capacity() * sizeof(cv::Point2d) + taken_.capacity() / 8;
+    }
+
+} // uvdar
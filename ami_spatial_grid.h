@@ -0,0 +1,79 @@
+#pragma once
+
+#include <opencv2/highgui/highgui.hpp>
+#include <bits/stdc++.h>
+#include "ami_gating_kernel.h"
+#include "ami_points_view.h"
+
+namespace uvdar{
+
+    /**
+     * @brief uniform grid over the points of one frame. The points are bucketed by a counting sort into cells of (at least) the size of "max_px_shift",
+     * so a search window only has to visit the cells it overlaps instead of every point of the frame
+     */
+    class SpatialGrid{
+
+        private:
+            cv::Point2d min_cell_size_;
+            cv::Point2d cell_size_;
+            cv::Point2d origin_;
+            int cols_ = 0;
+            int rows_ = 0;
+
+            std::vector<int> cell_start_; // first entry of each cell in sorted_idx_, size cols_*rows_ + 1
+            std::vector<int> sorted_idx_; // indices of the frame points ordered by cell
+            std::vector<double> sorted_x_; // coordinates ordered by cell (SoA for the gating kernel), NaN once the point is taken
+            std::vector<double> sorted_y_;
+            std::vector<int> sorted_pos_; // position of each frame point in the sorted arrays
+            std::vector<cv::Point2d> points_; // frame points in the original order
+            std::vector<int> cell_of_point_;
+            std::vector<int> fill_pos_;
+            std::vector<bool> taken_;
+            int remaining_ = 0;
+
+            /**
+             * @brief bucket the points stored in points_ into the grid cells
+             */
+            void bucketPoints();
+
+            int cellCol(double) const;
+            int cellRow(double) const;
+
+        public:
+            SpatialGrid(const cv::Point&);
+            ~SpatialGrid();
+
+            /**
+             * @brief build the index over the points of the current frame
+             * @param frame points of the frame, the index of a point in the view is its index in the grid
+             */
+            void build(const PointsView&);
+
+            /**
+             * @brief all not yet taken points inside the box with their squared distance to the anchor - the candidates of a track for the assignment.
+             * The cells of one grid row overlapped by the box are contiguous in the sorted arrays, so each row is gated in batches by the vectorized gating kernel
+             * @param anchor reference point for the distance
+             * @param left_top
+             * @param right_bottom
+             * @param candidates output, the points are appended
+             */
+            void candidatesInBox(const cv::Point2d&, const cv::Point2d&, const cv::Point2d&, std::vector<GatingCandidate>&) const;
+
+            /**
+             * @brief mark point as inserted into a sequence - it will not be returned by candidatesInBox() anymore
+             * @param index index of the point in the frame
+             */
+            void take(int);
+
+            bool isTaken(int index) const { return taken_[index]; }
+            int size() const { return (int)points_.size(); }
+            const cv::Point2d& point(int index) const { return points_[index]; }
+            int remaining() const { return remaining_; }
+
+            /**
+             * @brief heap storage of the index in bytes
+             */
+            size_t memoryBytes() const;
+    };
+
+} // uvdar
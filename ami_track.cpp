@@ -0,0 +1,145 @@
+#include "ami_track.h"
+
+namespace uvdar
+{
+
+    Track::Track(int capacity)
+    {
+        capacity = std::max(capacity, 1);
+        x_.resize(capacity);
+        y_.resize(capacity);
+        stamp_ns_.resize(capacity);
+        led_bits_.resize((capacity + 63) / 64);
+    }
+
+    Track::~Track()
+    {
+    }
+
+    void Track::push(const TrackSample &sample)
+    {
+        int slot;
+        if (size_ < (int)x_.size())
+        {
+            slot = physicalIndex(size_);
+            size_++;
+        }
+        else
+        {
+            // full - the slot of the oldest point becomes the newest
+            slot = head_;
+            if (slotLedState(slot))
+                prediction_cache_.valid = false;
+            head_ = physicalIndex(1);
+        }
+        x_[slot] = sample.x;
+        y_[slot] = sample.y;
+        stamp_ns_[slot] = sample.stamp_ns;
+        const uint64_t bit = uint64_t(1) << (slot & 63);
+        led_bits_[slot >> 6] = sample.led_state ? (led_bits_[slot >> 6] | bit) : (led_bits_[slot >> 6] & ~bit);
+        led_history_ = (led_history_ << 1) | uint64_t(sample.led_state);
+        consecutive_zeros_ = sample.led_state ? 0 : consecutive_zeros_ + 1;
+        signal_id_valid_ = false;
+        if (sample.led_state)
+            prediction_cache_.valid = false;
+    }
+
+    void Track::reset()
+    {
+        head_ = 0;
+        size_ = 0;
+        led_history_ = 0;
+        consecutive_zeros_ = 0;
+        signal_id_ = -1;
+        signal_id_valid_ = false;
+        track_id_ = 0;
+        resetStatistics();
+        regression_.reset();
+        kalman_.reset();
+        prediction_cache_ = PredictionCache();
+    }
+
+    void Track::resetStatistics()
+    {
+        x_statistics_ = PredictionStatistics();
+        y_statistics_ = PredictionStatistics();
+    }
+
+    void Track::save(SnapshotWriter &writer) const
+    {
+        writer.write(size_);
+        // the ring is written as at most two contiguous runs, oldest point first
+        const int first_run = std::min(size_, (int)x_.size() - head_);
+        writer.writeArray(x_.data() + head_, first_run);
+        writer.writeArray(x_.data(), size_ - first_run);
+        writer.writeArray(y_.data() + head_, first_run);
+        writer.writeArray(y_.data(), size_ - first_run);
+        writer.writeArray(stamp_ns_.data() + head_, first_run);
+        writer.writeArray(stamp_ns_.data(), size_ - first_run);
+        for (int word = 0; word < (size_ + 63) / 64; ++word)
+        {
+            uint64_t bits = 0;
+            for (int i = word * 64; i < std::min(size_, word * 64 + 64); ++i)
+                bits |= uint64_t(slotLedState(physicalIndex(i))) << (i & 63);
+            writer.write(bits);
+        }
+        writer.write(led_history_);
+        writer.write(consecutive_zeros_);
+        writer.write(signal_id_);
+        writer.writeFlag(signal_id_valid_);
+        writer.write(track_id_);
+        writer.write(x_statistics_);
+        writer.write(y_statistics_);
+        writer.write(regression_);
+        writer.write(kalman_);
+        writer.write(prediction_cache_);
+    }
+
+    bool Track::load(SnapshotReader &reader)
+    {
+        reset();
+        int size = 0;
+        if (!reader.read(size) || size < 0 || size > (int)x_.size())
+            return false;
+        const bool ok = reader.readArray(x_.data(), size) && reader.readArray(y_.data(), size) && reader.readArray(stamp_ns_.data(), size) &&
+                        reader.readArray(led_bits_.data(), (size + 63) / 64) && reader.read(led_history_) && reader.read(consecutive_zeros_) &&
+                        reader.read(signal_id_) && reader.readFlag(signal_id_valid_) && reader.read(track_id_) &&
+                        reader.readRecord(x_statistics_, {offsetof(PredictionStatistics, poly_reg_computed), offsetof(PredictionStatistics, extended_search)}) &&
+                        reader.readRecord(y_statistics_, {offsetof(PredictionStatistics, poly_reg_computed), offsetof(PredictionStatistics, extended_search)}) &&
+                        reader.read(regression_) && reader.read(kalman_) &&
+                        reader.readRecord(prediction_cache_, {offsetof(PredictionCache, valid), offsetof(PredictionCache, computed), offsetof(PredictionCache, solved)});
+        // the counts index fixed-size arrays, a damaged record must not reach them
+        auto validCoeffCount = [](const int &count)
+        { return count >= 0 && count <= max_poly_order + 1; };
+        const bool consistent = ok && consecutive_zeros_ >= 0 && consecutive_zeros_ <= size && signal_id_ >= -1 && validCoeffCount(x_statistics_.coeff_count) &&
+                                validCoeffCount(y_statistics_.coeff_count) && validCoeffCount(prediction_cache_.fit.coeff_count) && prediction_cache_.n >= 0 &&
+                                prediction_cache_.n <= size && regression_.count() >= 0 && regression_.count() <= size && kalman_.states() >= 0 &&
+                                kalman_.states() <= KalmanFilter::max_states && kalman_.measurements() >= 0;
+        if (!consistent)
+        {
+            reset();
+            return false;
+        }
+        size_ = size;
+        return true;
+    }
+
+    uint32_t Track::snapshotLayout()
+    {
+        uint32_t layout = 2166136261u;
+        for (size_t size : {sizeof(PredictionStatistics), sizeof(RecursiveRegression), sizeof(KalmanFilter), sizeof(PredictionCache)})
+            layout = (layout ^ (uint32_t)size) * 16777619u;
+        return layout;
+    }
+
+    PointState Track::operator[](int i) const
+    {
+        const int slot = physicalIndex(i);
+        PointState point;
+        point.point = cv::Point2d(x_[slot], y_[slot]);
+        point.led_state = slotLedState(slot);
+        point.insert_stamp_ns = stamp_ns_[slot];
+        return point;
+    }
+
+} // namespace uvdar
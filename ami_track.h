@@ -0,0 +1,199 @@
+#pragma once
+
+#include "ami_extended_search.h"
+#include "ami_recursive_regression.h"
+#include "ami_kalman_filter.h"
+#include "ami_snapshot.h"
+
+namespace uvdar
+{
+
+    struct PointState{
+        cv::Point2d point;
+        bool led_state;
+        int64_t insert_stamp_ns;
+    };
+
+    // one stored point of a track in the internal representation, without ROS types
+    struct TrackSample{
+        float x;
+        float y;
+        int64_t stamp_ns;
+        bool led_state;
+    };
+
+    /**
+     * @brief regression result of a track. The regression only depends on the "on"-points, so it stays valid until an "on"-point is inserted into or leaves the track
+     */
+    struct PredictionCache{
+        bool valid = false;
+        bool computed = false; // false if the track has too few points for a regression
+        bool solved = false;
+        PolyFitXY fit;
+        int n = 0; // number of points used for the regression
+        int64_t reference_ns = 0; // origin of the time values
+        double mean_time = 0.0; // weighted mean of the time values
+        double var_time = 0.0; // sum of the squared deviations of the time values from mean_time
+    };
+
+    /**
+     * @brief fixed-capacity circular buffer of the points of one generated sequence.
+     * The samples are stored as structure of arrays (float position, timestamp in nanoseconds, led state packed as bits), the prediction statistics only once for the whole track - they always belong to the newest point.
+     * Additionally the newest 64 led states are kept as rolling word for matching against the original sequences, the match result is cached until the next point is pushed.
+     * The storage is allocated once at construction, pushing to a full track overwrites the oldest point. Index 0 and begin() refer to the oldest stored point
+     */
+    class Track{
+
+        private:
+            std::vector<float> x_;
+            std::vector<float> y_;
+            std::vector<int64_t> stamp_ns_;
+            std::vector<uint64_t> led_bits_; // led state of each slot, bit (slot % 64) of word (slot / 64)
+            uint64_t led_history_ = 0; // newest led states, bit 0 is the newest point
+            int head_ = 0; // physical index of the oldest point
+            int size_ = 0;
+            int consecutive_zeros_ = 0; // number of "off"-points at the end of the track
+            int signal_id_ = -1;
+            bool signal_id_valid_ = false;
+            uint64_t track_id_ = 0; // assigned by the tracker when the track is created
+
+            PredictionStatistics x_statistics_;
+            PredictionStatistics y_statistics_;
+            RecursiveRegression regression_; // only maintained for PredictorMode::recursive_least_squares
+            KalmanFilter kalman_; // only maintained for PredictorMode::constant_velocity and constant_acceleration
+            PredictionCache prediction_cache_;
+
+            int physicalIndex(int i) const { int p = head_ + i; return (p >= (int)x_.size()) ? p - (int)x_.size() : p; }
+            bool slotLedState(int slot) const { return (led_bits_[slot >> 6] >> (slot & 63)) & 1; }
+
+        public:
+
+            /**
+             * @brief random access iterator over the points in time order, dereferencing assembles the PointState by value
+             */
+            class ConstIterator{
+                private:
+                    const Track* track_;
+                    int index_;
+
+                    struct ArrowProxy{
+                        PointState point;
+                        const PointState* operator->() const { return &point; }
+                    };
+                public:
+                    using iterator_category = std::random_access_iterator_tag;
+                    using value_type = PointState;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = ArrowProxy;
+                    using reference = PointState;
+
+                    ConstIterator(const Track* track, int index) : track_(track), index_(index) {}
+
+                    reference operator*() const { return (*track_)[index_]; }
+                    pointer operator->() const { return ArrowProxy{(*track_)[index_]}; }
+                    reference operator[](difference_type n) const { return (*track_)[index_ + (int)n]; }
+
+                    ConstIterator& operator++() { ++index_; return *this; }
+                    ConstIterator& operator--() { --index_; return *this; }
+                    ConstIterator operator++(int) { ConstIterator tmp = *this; ++index_; return tmp; }
+                    ConstIterator operator--(int) { ConstIterator tmp = *this; --index_; return tmp; }
+                    ConstIterator& operator+=(difference_type n) { index_ += (int)n; return *this; }
+                    ConstIterator& operator-=(difference_type n) { index_ -= (int)n; return *this; }
+                    ConstIterator operator+(difference_type n) const { return ConstIterator(track_, index_ + (int)n); }
+                    ConstIterator operator-(difference_type n) const { return ConstIterator(track_, index_ - (int)n); }
+                    difference_type operator-(const ConstIterator& other) const { return index_ - other.index_; }
+
+                    bool operator==(const ConstIterator& other) const { return index_ == other.index_; }
+                    bool operator!=(const ConstIterator& other) const { return index_ != other.index_; }
+                    bool operator<(const ConstIterator& other) const { return index_ < other.index_; }
+                    bool operator>(const ConstIterator& other) const { return index_ > other.index_; }
+                    bool operator<=(const ConstIterator& other) const { return index_ <= other.index_; }
+                    bool operator>=(const ConstIterator& other) const { return index_ >= other.index_; }
+            };
+
+            using const_iterator = ConstIterator;
+
+            Track(int);
+            ~Track();
+
+            /**
+             * @brief append point to the end of the track, if the capacity is reached the oldest point is overwritten.
+             * Invalidates the prediction cache if an "on"-point is appended or overwritten
+             * @param sample point that will be appended
+             */
+            void push(const TrackSample&);
+
+            /**
+             * @brief remove all points and statistics, the capacity is kept
+             */
+            void reset();
+
+            /**
+             * @brief reset the prediction statistics of the track - used if the newest point was not inserted by the extended search
+             */
+            void resetStatistics();
+
+            /**
+             * @brief append the points (oldest first), the led states, the cached id and prediction and the predictor state to the snapshot
+             */
+            void save(SnapshotWriter&) const;
+
+            /**
+             * @brief replace the content of the track by a track written with save()
+             * @return false if the record is truncated, has more points than the capacity or a count or flag out of range - the track is then empty
+             */
+            bool load(SnapshotReader&);
+
+            /**
+             * @brief changes whenever the layout of the records written by save() changes
+             */
+            static uint32_t snapshotLayout();
+
+            int size() const { return size_; }
+            int capacity() const { return (int)x_.size(); }
+            bool empty() const { return size_ == 0; }
+
+            float x(int i) const { return x_[physicalIndex(i)]; }
+            float y(int i) const { return y_[physicalIndex(i)]; }
+            int64_t stampNs(int i) const { return stamp_ns_[physicalIndex(i)]; }
+            double timeSec(int i) const { return stamp_ns_[physicalIndex(i)] * 1e-9; }
+            bool ledState(int i) const { return slotLedState(physicalIndex(i)); }
+            uint64_t ledHistory() const { return led_history_; }
+            int consecutiveZeros() const { return std::min(consecutive_zeros_, size_); }
+
+            /**
+             * @brief id of the matched original sequence, cached since the last push
+             * @param id output, only set if the cache is valid
+             * @return true if the cached id is valid
+             */
+            bool cachedSignalId(int& id) const { id = signal_id_; return signal_id_valid_; }
+            void setSignalId(int id) { signal_id_ = id; signal_id_valid_ = true; }
+
+            uint64_t trackId() const { return track_id_; }
+            void setTrackId(uint64_t id) { track_id_ = id; }
+
+            TrackSample sample(int i) const { const int slot = physicalIndex(i); return TrackSample{x_[slot], y_[slot], stamp_ns_[slot], slotLedState(slot)}; }
+
+            PointState operator[](int) const;
+            PointState back() const { return (*this)[size_ - 1]; }
+
+            PredictionStatistics& xStatistics() { return x_statistics_; }
+            PredictionStatistics& yStatistics() { return y_statistics_; }
+            const PredictionStatistics& xStatistics() const { return x_statistics_; }
+            const PredictionStatistics& yStatistics() const { return y_statistics_; }
+            RecursiveRegression& regression() { return regression_; }
+            const RecursiveRegression& regression() const { return regression_; }
+            KalmanFilter& kalman() { return kalman_; }
+            const KalmanFilter& kalman() const { return kalman_; }
+            PredictionCache& predictionCache() { return prediction_cache_; }
+
+            /**
+             * @brief heap storage of the track in bytes, without sizeof(Track)
+             */
+            size_t memoryBytes() const { return x_.capacity() * sizeof(float) + y_.capacity() * sizeof(float) + stamp_ns_.capacity() * sizeof(int64_t) + led_bits_.capacity() * sizeof(uint64_t); }
+
+            const_iterator begin() const { return const_iterator(this, 0); }
+            const_iterator end() const { return const_iterator(this, size_); }
+    };
+
+} // namespace uvdar
@@ -0,0 +1,47 @@
+#include "ami_track_events.h"
+
+namespace uvdar
+{
+
+    void TrackEventBuffer::reset(const size_t &max_pending)
+    {
+        std::scoped_lock lock(mutex_);
+        max_pending_ = max_pending;
+        overflowed_ = false;
+        frame_events_.clear();
+        pending_.clear();
+        frame_events_.reserve(max_pending_);
+        pending_.reserve(max_pending_);
+    }
+
+    void TrackEventBuffer::commit()
+    {
+        if (frame_events_.empty())
+            return;
+        {
+            std::scoped_lock lock(mutex_);
+            // a frame is dropped as a whole, the consumer has to resynchronize anyway
+            if (pending_.size() + frame_events_.size() > max_pending_)
+            {
+                overflowed_ = true;
+            }
+            else
+            {
+                pending_.insert(pending_.end(), frame_events_.begin(), frame_events_.end());
+            }
+        }
+        frame_events_.clear();
+    }
+
+    bool TrackEventBuffer::poll(std::vector<TrackEvent> &events)
+    {
+        events.clear();
+        std::scoped_lock lock(mutex_);
+        std::swap(events, pending_);
+        pending_.reserve(max_pending_);
+        const bool complete = !overflowed_;
+        overflowed_ = false;
+        return complete;
+    }
+
+} // uvdar
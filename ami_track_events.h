@@ -0,0 +1,63 @@
+#pragma once
+
+#include "ami_track_pool.h"
+
+namespace uvdar{
+
+    enum class TrackEventType : uint8_t{
+        created, // new track from an unassigned point
+        identity_changed, // the matched original sequence changed, also from or to -1 (no match)
+        position_updated, // an "on"-point was inserted, "off"-points keep the position and are not reported
+        lost // the track was pruned, its handle is stale from now on
+    };
+
+    // change of one track
+    struct TrackEvent{
+        TrackEventType type;
+        uint64_t track_id; // stable over the whole lifetime of the track, never reused by the tracker
+        TrackHandle handle; // for AMI::getSequence() until the track is lost
+        int64_t stamp_ns; // time stamp of the frame the change happened in
+        float x; // newest position of the track
+        float y;
+        int id; // matched original sequence after the change, -1 if none
+        int previous_id; // identity_changed: matched sequence before the change, otherwise equal to id
+    };
+
+    /**
+     * @brief collects the events of the frame that is processed and hands them over to one consumer in batches.
+     * The producer only takes the lock once per frame to append the events of the frame, the consumer only to swap the pending events out.
+     * At most max_pending events are kept between two polls - the events of a frame that does not fit anymore are dropped and reported by poll()
+     */
+    class TrackEventBuffer{
+
+        private:
+            std::vector<TrackEvent> frame_events_; // owned by the producer
+            std::mutex mutex_;
+            std::vector<TrackEvent> pending_;
+            size_t max_pending_ = 0;
+            bool overflowed_ = false;
+
+        public:
+            /**
+             * @param max_pending maximal number of events between two polls, 0 disables the buffer - record() and commit() do nothing
+             */
+            void reset(const size_t&);
+
+            bool enabled() const { return max_pending_ > 0; }
+
+            void record(const TrackEvent& event) { if(max_pending_ > 0) frame_events_.push_back(event); }
+
+            /**
+             * @brief make the events of the current frame available to poll(), called by the producer at the end of a frame
+             */
+            void commit();
+
+            /**
+             * @brief take all pending events in the order they happened
+             * @param events output, replaced - its storage is swapped into the buffer and reused
+             * @return false if events were dropped since the last poll
+             */
+            bool poll(std::vector<TrackEvent>&);
+    };
+
+} // uvdar
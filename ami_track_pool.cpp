@@ -0,0 +1,106 @@
+#include "ami_track_pool.h"
+
+namespace uvdar
+{
+
+    TrackPool::TrackPool()
+    {
+    }
+
+    TrackPool::~TrackPool()
+    {
+    }
+
+    void TrackPool::reset(const int &max_tracks, const int &track_capacity)
+    {
+        max_tracks_ = std::max(max_tracks, 0);
+        track_capacity_ = track_capacity;
+        tracks_.clear();
+        tracks_.reserve(max_tracks_);
+        // keep the generations growing, handles of the previous configuration must not become valid again
+        for (auto &generation : generations_)
+            generation++;
+        generations_.resize(max_tracks_, 1);
+        alive_.assign(max_tracks_, false);
+        free_slots_.clear();
+        free_slots_.reserve(max_tracks_);
+        occupied_ = 0;
+        high_water_mark_ = 0;
+        rejected_ = 0;
+    }
+
+    TrackHandle TrackPool::acquire()
+    {
+        uint32_t index;
+        if (!free_slots_.empty())
+        {
+            index = free_slots_.back();
+            free_slots_.pop_back();
+            tracks_[index].reset();
+        }
+        else if ((int)tracks_.size() < max_tracks_)
+        {
+            index = (uint32_t)tracks_.size();
+            tracks_.emplace_back(track_capacity_);
+        }
+        else
+        {
+            rejected_++;
+            return TrackHandle();
+        }
+
+        alive_[index] = true;
+        occupied_++;
+        high_water_mark_ = std::max(high_water_mark_, occupied_);
+        TrackHandle handle;
+        handle.index = index;
+        handle.generation = generations_[index];
+        return handle;
+    }
+
+    void TrackPool::release(const TrackHandle &handle)
+    {
+        if (get(handle) == nullptr)
+            return;
+        alive_[handle.index] = false;
+        generations_[handle.index]++;
+        free_slots_.push_back(handle.index);
+        occupied_--;
+    }
+
+    Track *TrackPool::get(const TrackHandle &handle)
+    {
+        if (handle.index >= tracks_.size() || !alive_[handle.index] || generations_[handle.index] != handle.generation)
+            return nullptr;
+        return &tracks_[handle.index];
+    }
+
+    const Track *TrackPool::get(const TrackHandle &handle) const
+    {
+        if (handle.index >= tracks_.size() || !alive_[handle.index] || generations_[handle.index] != handle.generation)
+            return nullptr;
+        return &tracks_[handle.index];
+    }
+
+    TrackPoolStatistics TrackPool::statistics() const
+    {
+        TrackPoolStatistics statistics;
+        statistics.capacity = max_tracks_;
+        statistics.constructed = (int)tracks_.size();
+        statistics.occupied = occupied_;
+        statistics.high_water_mark = high_water_mark_;
+        statistics.rejected = rejected_;
+        return statistics;
+    }
+
+    size_t TrackPool::memoryBytes() const
+    {
+        size_t bytes = tracks_.capacity() * sizeof(Track) + generations_.capacity() * sizeof(uint32_t) + alive_.capacity() * sizeof(uint8_t) + free_slots_.capacity() * sizeof(uint32_t);
+        for (const auto &track : tracks_)
+        {
+            bytes += track.memoryBytes();
+        }
+        return bytes;
+    }
+
+} // namespace uvdar
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "ami_track.h"
+
+namespace uvdar
+{
+
+    /**
+     * @brief stable identifier of a track in the TrackPool. A handle becomes stale once its track is released - the slot generation is checked on every checked access
+     */
+    struct TrackHandle{
+        static constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+        uint32_t index = invalid_index;
+        uint32_t generation = 0;
+
+        bool valid() const { return index != invalid_index; }
+        bool operator==(const TrackHandle& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const TrackHandle& other) const { return !(*this == other); }
+    };
+
+    struct TrackPoolStatistics{
+        int capacity; // maximal number of tracks
+        int constructed; // slots with allocated track storage
+        int occupied; // tracks currently in use
+        int high_water_mark; // maximal number of tracks in use at the same time
+        int rejected; // track requests that failed because the pool was full
+    };
+
+    /**
+     * @brief pool of tracks with a fixed maximal number of slots. Released tracks are recycled, so after the slots were used once no heap allocation is done for new tracks
+     */
+    class TrackPool{
+
+        private:
+            int max_tracks_ = 0;
+            int track_capacity_ = 0;
+            std::vector<Track> tracks_; // reserved for max_tracks_ - never reallocated
+            std::vector<uint32_t> generations_;
+            std::vector<uint8_t> alive_;
+            std::vector<uint32_t> free_slots_;
+            int occupied_ = 0;
+            int high_water_mark_ = 0;
+            int rejected_ = 0;
+
+        public:
+            TrackPool();
+            ~TrackPool();
+
+            /**
+             * @brief release all tracks and set the dimensions of the pool - all handles become stale
+             * @param max_tracks maximal number of tracks in use at the same time
+             * @param track_capacity number of points per track
+             */
+            void reset(const int&, const int&);
+
+            /**
+             * @brief take a free track from the pool, the track is empty
+             * @return handle of the track, invalid handle if all slots are in use
+             */
+            TrackHandle acquire();
+
+            /**
+             * @brief give the track back to the pool, the handle and all copies of it become stale
+             */
+            void release(const TrackHandle&);
+
+            /**
+             * @brief checked access
+             * @return nullptr if the handle is stale or invalid
+             */
+            Track* get(const TrackHandle&);
+            const Track* get(const TrackHandle&) const;
+
+            /**
+             * @brief unchecked access for handles that are known to be alive
+             */
+            Track& operator[](const TrackHandle& handle) { return tracks_[handle.index]; }
+            const Track& operator[](const TrackHandle& handle) const { return tracks_[handle.index]; }
+
+            TrackPoolStatistics statistics() const;
+
+            /**
+             * @brief heap storage of the pool and all constructed tracks in bytes
+             */
+            size_t memoryBytes() const;
+    };
+
+} // namespace uvdar
@@ -0,0 +1,269 @@
+#include "ami_tracker_host.h"
+
+namespace uvdar
+{
+
+    namespace
+    {
+        int64_t steadyClockNs()
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+    }
+
+    TrackerHost::TrackerHost(const loadedParamsForAMI &params, const int &streams, const int &tracker_threads)
+    {
+        params_ = params;
+        params_.async_queue_length = std::max(params.async_queue_length, 1);
+        worker_pool_ = std::make_shared<WorkerPool>(std::max(params.worker_threads, 0));
+
+        // the streams are fed by the host, their trackers process the frames in the calling thread
+        loadedParamsForAMI stream_params = params_;
+        stream_params.async_queue_length = 0;
+        stream_params.worker_threads = 0;
+        streams_.reserve(std::max(streams, 0));
+        for (int i = 0; i < streams; ++i)
+        {
+            auto stream = std::make_unique<Stream>();
+            stream->tracker = std::make_unique<AMI>(stream_params, worker_pool_);
+            stream->queue = std::make_unique<FrameQueue>(params_.async_queue_length);
+            streams_.push_back(std::move(stream));
+        }
+
+        if (streams_.empty())
+            return;
+        for (int i = 0; i < std::max(tracker_threads, 1); ++i)
+        {
+            threads_.emplace_back(&TrackerHost::threadLoop, this);
+        }
+    }
+
+    TrackerHost::~TrackerHost()
+    {
+        {
+            std::scoped_lock lock(mutex_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto &stream : streams_)
+        {
+            stream->queue->stop(); // releases producers blocked on a full queue
+        }
+        for (auto &thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    bool TrackerHost::setSequences(const std::vector<std::vector<bool>> &sequences)
+    {
+        tables_ = std::make_shared<const SequenceTables>(sequences, params_.allowed_BER_per_seq, params_.stored_seq_len_factor, params_.decay_factor, params_.conf_probab_percent);
+        bool accepted = true;
+        for (auto &stream : streams_)
+        {
+            accepted = stream->tracker->setSequences(tables_) && accepted;
+        }
+        return accepted;
+    }
+
+    void TrackerHost::setDebugFlags(bool debug)
+    {
+        for (auto &stream : streams_)
+        {
+            stream->tracker->setDebugFlags(debug);
+        }
+    }
+
+    void TrackerHost::updateFramerate(const int &stream, double framerate)
+    {
+        streams_[stream]->tracker->updateFramerate(framerate);
+    }
+
+    void TrackerHost::submitFrame(const int &stream, const PointsView &points, const int64_t &stamp_ns)
+    {
+        streams_[stream]->tracker->recordFrame(points, stamp_ns);
+        streams_[stream]->queue->push(points, stamp_ns, params_.backpressure_policy);
+        notifyWork();
+    }
+
+    bool TrackerHost::recordFrames(const int &stream, const std::string &path)
+    {
+        return streams_[stream]->tracker->recordFrames(path);
+    }
+
+    bool TrackerHost::writeSnapshot(const int &stream, const std::string &path)
+    {
+        claimStream(*streams_[stream]);
+        const bool written = streams_[stream]->tracker->writeSnapshot(path);
+        releaseStream(*streams_[stream]);
+        return written;
+    }
+
+    bool TrackerHost::readSnapshot(const int &stream, const std::string &path)
+    {
+        claimStream(*streams_[stream]);
+        const bool restored = streams_[stream]->tracker->readSnapshot(path);
+        releaseStream(*streams_[stream]);
+        return restored;
+    }
+
+    void TrackerHost::claimStream(Stream &stream)
+    {
+        bool expected = false;
+        while (!stream.busy.compare_exchange_weak(expected, true, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            expected = false;
+            std::this_thread::yield();
+        }
+    }
+
+    void TrackerHost::releaseStream(Stream &stream)
+    {
+        stream.busy.store(false, std::memory_order_seq_cst);
+        // the tracker threads skipped the stream while it was claimed
+        if (stream.queue->depth() > 0)
+            notifyWork();
+    }
+
+    void TrackerHost::notifyWork()
+    {
+        if (sleeping_threads_.load(std::memory_order_seq_cst) > 0)
+        {
+            std::scoped_lock lock(mutex_);
+            work_cv_.notify_one();
+        }
+    }
+
+    bool TrackerHost::hasWork() const
+    {
+        for (const auto &stream : streams_)
+        {
+            if (stream->queue->depth() > 0 && !stream->busy.load(std::memory_order_seq_cst))
+                return true;
+        }
+        return false;
+    }
+
+    void TrackerHost::threadLoop()
+    {
+        while (!stop_.load(std::memory_order_relaxed))
+        {
+            if (processNext())
+                continue;
+
+            std::unique_lock lock(mutex_);
+            sleeping_threads_.fetch_add(1, std::memory_order_seq_cst);
+            work_cv_.wait(lock, [this]
+                          { return stop_.load(std::memory_order_relaxed) || hasWork(); });
+            sleeping_threads_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool TrackerHost::processNext()
+    {
+        const size_t count = streams_.size();
+        const size_t first = next_stream_.fetch_add(1, std::memory_order_relaxed) % count;
+        for (size_t k = 0; k < count; ++k)
+        {
+            Stream &stream = *streams_[(first + k) % count];
+            if (stream.queue->depth() == 0)
+                continue;
+            bool expected = false;
+            if (!stream.busy.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed))
+                continue;
+
+            const bool taken = stream.queue->pop(stream.frame);
+            if (taken)
+            {
+                const int64_t start_ns = steadyClockNs();
+                stream.queue_wait.record((uint64_t)std::max<int64_t>(start_ns - stream.frame.enqueue_ns, 0));
+
+                // coalescing: in a backlog only the newest frame is published
+                const bool publish = params_.backpressure_policy != BackpressurePolicy::coalesce || stream.queue->depth() == 0;
+                stream.tracker->processFrame(PointsView::fromInterleaved(stream.frame.xy.data(), stream.frame.xy.size() / 2), stream.frame.stamp_ns, publish);
+                if (!publish)
+                    stream.coalesced.fetch_add(1, std::memory_order_relaxed);
+
+                stream.latency.record((uint64_t)std::max<int64_t>(steadyClockNs() - stream.frame.enqueue_ns, 0));
+                stream.processed.fetch_add(1, std::memory_order_release);
+            }
+            stream.busy.store(false, std::memory_order_seq_cst);
+            // frames that arrived while the stream was claimed may have been skipped by a sleeping thread
+            if (stream.queue->depth() > 0)
+                notifyWork();
+            if (taken)
+                return true;
+        }
+        return false;
+    }
+
+    void TrackerHost::flush()
+    {
+        for (auto &stream : streams_)
+        {
+            while (stream->processed.load(std::memory_order_acquire) + stream->queue->dropped() < stream->queue->enqueued())
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    }
+
+    const ResultSnapshot &TrackerHost::getResults(const int &stream)
+    {
+        return streams_[stream]->tracker->getResults();
+    }
+
+    bool TrackerHost::pollEvents(const int &stream, std::vector<TrackEvent> &events)
+    {
+        return streams_[stream]->tracker->pollEvents(events);
+    }
+
+    HostStatistics TrackerHost::getStatistics()
+    {
+        HostStatistics statistics;
+        statistics.tracker_threads = (int)threads_.size();
+        statistics.worker_threads = worker_pool_->workers();
+        LatencyHistogram queue_wait, latency;
+        for (auto &stream : streams_)
+        {
+            StreamStatistics stream_statistics;
+            stream_statistics.tracker = stream->tracker->getStatistics();
+
+            IngestionStatistics &ingestion = stream_statistics.ingestion;
+            ingestion.asynchronous = true;
+            ingestion.policy = params_.backpressure_policy;
+            ingestion.capacity = stream->queue->capacity();
+            ingestion.depth = stream->queue->depth();
+            ingestion.max_depth = stream->queue->maxDepth();
+            ingestion.enqueued = stream->queue->enqueued();
+            ingestion.processed = stream->processed.load(std::memory_order_relaxed);
+            ingestion.dropped = stream->queue->dropped();
+            ingestion.coalesced = stream->coalesced.load(std::memory_order_relaxed);
+            ingestion.queue_wait = stream->queue_wait.statistics();
+            ingestion.latency = stream->latency.statistics();
+            queue_wait.merge(stream->queue_wait);
+            latency.merge(stream->latency);
+
+            statistics.frames += stream_statistics.tracker.frames;
+            statistics.points += stream_statistics.tracker.points;
+            statistics.dropped_frames += ingestion.dropped;
+            statistics.active_tracks += stream_statistics.tracker.active_tracks;
+            statistics.memory_bytes += stream_statistics.tracker.memory_bytes;
+            statistics.streams.push_back(stream_statistics);
+        }
+        statistics.queue_wait = queue_wait.statistics();
+        statistics.latency = latency.statistics();
+        return statistics;
+    }
+
+    void TrackerHost::resetStatistics()
+    {
+        for (auto &stream : streams_)
+        {
+            stream->tracker->resetStatistics();
+            stream->queue_wait.reset();
+            stream->latency.reset();
+        }
+    }
+
+} // uvdar
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "ami.h"
+
+namespace uvdar{
+
+    struct StreamStatistics{
+        TrackerStatistics tracker;
+        IngestionStatistics ingestion;
+    };
+
+    // statistics of all streams of a TrackerHost
+    struct HostStatistics{
+        std::vector<StreamStatistics> streams; // index = stream
+        int tracker_threads = 0;
+        int worker_threads = 0; // threads of the shared worker pool
+        uint64_t frames = 0; // processed frames of all streams
+        uint64_t points = 0;
+        uint64_t dropped_frames = 0;
+        int active_tracks = 0;
+        size_t memory_bytes = 0; // storage of all trackers, the shared tables are not included
+        StageStatistics queue_wait; // over the frames of all streams
+        StageStatistics latency; // over the frames of all streams
+    };
+
+    /**
+     * @brief runs the trackers of several cameras (streams) on a fixed set of threads.
+     * All streams share one worker pool for the predictions and one set of SequenceTables, so an additional camera only adds its tracks and its frame queue.
+     * Every stream has its own frame queue; the tracker threads take the frames round-robin over the streams, one frame per turn, so a stream with a backlog cannot starve the others.
+     * A stream is only processed by one thread at a time, its frames are processed in order
+     */
+    class TrackerHost{
+
+        private:
+            struct Stream{
+                std::unique_ptr<AMI> tracker;
+                std::unique_ptr<FrameQueue> queue;
+                QueuedFrame frame; // frame the owning thread is working on
+                std::atomic<bool> busy{false}; // claimed by a tracker thread
+                std::atomic<uint64_t> processed{0};
+                std::atomic<uint64_t> coalesced{0};
+                LatencyHistogram queue_wait;
+                LatencyHistogram latency;
+            };
+
+            loadedParamsForAMI params_;
+            std::shared_ptr<WorkerPool> worker_pool_;
+            std::shared_ptr<const SequenceTables> tables_;
+            std::vector<std::unique_ptr<Stream>> streams_;
+
+            std::vector<std::thread> threads_;
+            std::atomic<uint64_t> next_stream_{0}; // round-robin cursor
+            std::mutex mutex_;
+            std::condition_variable work_cv_;
+            std::atomic<int> sleeping_threads_{0};
+            std::atomic<bool> stop_{false};
+
+            /**
+             * @brief loop of a tracker thread, sleeps if no stream has a frame that can be taken
+             */
+            void threadLoop();
+
+            /**
+             * @brief claim the next stream after the round-robin cursor that has a queued frame and process one frame
+             * @return false if no frame could be taken
+             */
+            bool processNext();
+
+            /**
+             * @brief true if a stream has a queued frame and is not claimed by a thread
+             */
+            bool hasWork() const;
+
+            /**
+             * @brief wake one sleeping tracker thread, only takes the lock if a thread sleeps
+             */
+            void notifyWork();
+
+            /**
+             * @brief claim the stream like a tracker thread, waits until the thread processing a frame of it is done. The queue keeps accepting frames
+             */
+            void claimStream(Stream&);
+            void releaseStream(Stream&);
+
+        public:
+            /**
+             * @param params parameters of all streams. "worker_threads" is the size of the shared pool, "async_queue_length" the queue length per stream (at least 1) and "backpressure_policy" applies to every stream
+             * @param streams number of cameras
+             * @param tracker_threads threads taking the frames from the queues, at least 1
+             */
+            TrackerHost(const loadedParamsForAMI&, const int&, const int&);
+            ~TrackerHost();
+
+            int streams() const { return (int)streams_.size(); }
+
+            /**
+             * @brief build the tables of the sequences once and pass them to all streams, must not be called while frames are processed
+             * @return false if the sequences were rejected
+             */
+            bool setSequences(const std::vector<std::vector<bool>>&);
+
+            void setDebugFlags(bool);
+            void updateFramerate(const int&, double);
+
+            /**
+             * @brief copy the frame into the queue of the stream. Each stream must only be fed from one thread
+             * @param stream index of the camera
+             * @param points view of the (x, y) image points of the frame, only accessed during the call
+             * @param stamp_ns time stamp of the frame in nanoseconds
+             */
+            void submitFrame(const int&, const PointsView&, const int64_t&);
+
+            /**
+             * @brief record the submitted frames of a stream into a frame log, see AMI::recordFrames()
+             */
+            bool recordFrames(const int&, const std::string&);
+
+            /**
+             * @brief snapshot of the tracker of a stream to a file, see AMI::writeSnapshot(). The stream is claimed during the call, so the snapshot lies between two frames;
+             * the queued frames wait and the other streams continue
+             * @return false if the file cannot be written
+             */
+            bool writeSnapshot(const int&, const std::string&);
+
+            /**
+             * @brief restore the tracker of a stream from a snapshot file, see AMI::readSnapshot(). The stream is claimed during the call, the queued frames are processed afterwards
+             * @return false if the snapshot is rejected - the tracks of the stream are then kept
+             */
+            bool readSnapshot(const int&, const std::string&);
+
+            /**
+             * @brief wait until all submitted frames of all streams are processed
+             */
+            void flush();
+
+            /**
+             * @brief latest published results of a stream, see AMI::getResults(). One consumer thread per stream
+             */
+            const ResultSnapshot& getResults(const int&);
+
+            /**
+             * @brief changes of the tracks of a stream since the last call, see AMI::pollEvents(). One consumer thread per stream
+             */
+            bool pollEvents(const int&, std::vector<TrackEvent>&);
+
+            /**
+             * @brief tracker of a stream, e.g. for AMI::getSequence(). Must not be fed directly, snapshots are taken through writeSnapshot() and readSnapshot() of the host
+             */
+            AMI& tracker(const int& stream) { return *streams_[stream]->tracker; }
+
+            /**
+             * @brief per stream and aggregated statistics
+             */
+            HostStatistics getStatistics();
+            void resetStatistics();
+    };
+
+} // uvdar
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace uvdar{
+
+    /**
+     * @brief wait-free exchange of the latest value between one writer and one reader.
+     * The writer fills back() and publishes it, the reader always gets the latest published value. Both sides only do a single atomic exchange, neither side ever blocks the other.
+     * The buffers are reused, so values with reserved capacity (e.g. vectors) do not allocate once they reached their maximal size
+     */
+    template <typename T>
+    class TripleBuffer{
+
+        private:
+            static constexpr uint8_t index_mask_ = 0x3;
+            static constexpr uint8_t dirty_bit_ = 0x4; // set if the middle buffer holds a value the reader has not taken yet
+
+            std::array<T, 3> buffers_;
+            std::atomic<uint8_t> middle_{1};
+            uint8_t back_ = 0; // owned by the writer
+            uint8_t front_ = 2; // owned by the reader
+
+        public:
+            /**
+             * @brief buffer for the next value, only accessed by the writer
+             */
+            T& back() { return buffers_[back_]; }
+
+            /**
+             * @brief make the value in back() visible to the reader, back() then refers to a buffer not used by the reader
+             */
+            void publish(){
+                back_ = middle_.exchange(back_ | dirty_bit_, std::memory_order_acq_rel) & index_mask_;
+            }
+
+            /**
+             * @brief latest published value, only accessed by the reader. The reference stays valid until the next call of read()
+             */
+            const T& read(){
+                if(middle_.load(std::memory_order_acquire) & dirty_bit_){
+                    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index_mask_;
+                }
+                return buffers_[front_];
+            }
+    };
+
+} // uvdar
@@ -0,0 +1,107 @@
+#include "ami_worker_pool.h"
+
+namespace uvdar
+{
+
+    WorkerPool::WorkerPool(const int &workers)
+    {
+        const int thread_count = std::max(workers, 0);
+        blocks_ = std::make_unique<Block[]>(thread_count + 1);
+        threads_.reserve(thread_count);
+        for (int i = 0; i < thread_count; ++i)
+        {
+            threads_.emplace_back(&WorkerPool::workerLoop, this, i);
+        }
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::scoped_lock lock(mutex_);
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for (auto &thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    void WorkerPool::run(const int &count, TaskFunction task, void *context)
+    {
+        if (count <= 0)
+            return;
+
+        // with a shared pool the caller does not wait for the loop of another tracker, its own thread is free anyway
+        std::unique_lock loop_lock(loop_mutex_, std::try_to_lock);
+        const int participants = workers() + 1;
+        if (!loop_lock || participants == 1 || count == 1)
+        {
+            for (int i = 0; i < count; ++i)
+                task(context, i);
+            return;
+        }
+
+        for (int p = 0; p < participants; ++p)
+        {
+            blocks_[p].next.store((int)((int64_t)count * p / participants), std::memory_order_relaxed);
+            blocks_[p].end = (int)((int64_t)count * (p + 1) / participants);
+        }
+        {
+            std::scoped_lock lock(mutex_);
+            task_ = task;
+            task_context_ = context;
+            busy_workers_ = workers();
+            loop_number_++;
+        }
+        start_cv_.notify_all();
+
+        runBlocks(participants - 1);
+
+        std::unique_lock lock(mutex_);
+        done_cv_.wait(lock, [this]
+                      { return busy_workers_ == 0; });
+        task_ = nullptr;
+        task_context_ = nullptr;
+    }
+
+    void WorkerPool::workerLoop(const int &worker)
+    {
+        uint64_t seen_loop = 0;
+        while (true)
+        {
+            {
+                std::unique_lock lock(mutex_);
+                start_cv_.wait(lock, [&]
+                               { return stop_ || loop_number_ != seen_loop; });
+                if (stop_)
+                    return;
+                seen_loop = loop_number_;
+            }
+
+            runBlocks(worker);
+
+            bool last;
+            {
+                std::scoped_lock lock(mutex_);
+                last = (--busy_workers_ == 0);
+            }
+            if (last)
+                done_cv_.notify_one();
+        }
+    }
+
+    void WorkerPool::runBlocks(const int &own)
+    {
+        const int participants = workers() + 1;
+        for (int k = 0; k < participants; ++k)
+        {
+            Block &block = blocks_[(own + k) % participants];
+            for (int i = block.next.fetch_add(1, std::memory_order_relaxed); i < block.end; i = block.next.fetch_add(1, std::memory_order_relaxed))
+            {
+                task_(task_context_, i);
+            }
+        }
+    }
+
+} // uvdar
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <bits/stdc++.h>
+
+namespace uvdar{
+
+    /**
+     * @brief fixed set of worker threads for data parallel loops. The index range of a loop is split into one block per participant (workers + calling thread),
+     * a participant that finished its own block steals the remaining indices of the other blocks. The threads sleep between the loops
+     */
+    class WorkerPool{
+
+        private:
+            struct alignas(64) Block{
+                std::atomic<int> next{0};
+                int end = 0;
+            };
+
+            std::vector<std::thread> threads_;
+            std::unique_ptr<Block[]> blocks_; // one per participant, the calling thread uses the last one
+            using TaskFunction = void (*)(void*, int);
+            TaskFunction task_ = nullptr;
+            void* task_context_ = nullptr;
+
+            std::mutex loop_mutex_; // one loop at a time, parallelFor() may be called from several threads - a caller that finds the pool busy runs its loop alone
+            std::mutex mutex_;
+            std::condition_variable start_cv_;
+            std::condition_variable done_cv_;
+            uint64_t loop_number_ = 0;
+            int busy_workers_ = 0;
+            bool stop_ = false;
+
+            void workerLoop(const int&);
+
+            /**
+             * @brief run the indices of the own block, then steal from the blocks of the other participants
+             * @param own index of the block of the participant
+             */
+            void runBlocks(const int&);
+
+            /**
+             * @brief type erased loop, no heap allocation for the task
+             */
+            void run(const int&, TaskFunction, void*);
+
+        public:
+            /**
+             * @brief starts the worker threads
+             * @param workers number of threads besides the calling thread, 0 runs every loop in the calling thread
+             */
+            WorkerPool(const int&);
+            ~WorkerPool();
+
+            int workers() const { return (int)threads_.size(); }
+
+            /**
+             * @brief call task(i) for every i in [0, count) and return after all calls finished. The order of the calls is not defined.
+             * If the pool is running the loop of another thread (shared pool), the indices are processed by the calling thread instead of waiting
+             * @param count number of indices
+             * @param task callable with an int argument, called concurrently - must only write data owned by the index
+             */
+            template <typename Task>
+            void parallelFor(const int& count, Task& task){
+                run(count, [](void* context, int i){ (*static_cast<Task*>(context))(i); }, &task);
+            }
+    };
+
+} // uvdar